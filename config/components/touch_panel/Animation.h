@@ -0,0 +1,121 @@
+#include <cstdint>
+
+#ifndef animation_h
+#define animation_h
+
+namespace touch_panel {
+namespace anim {
+
+// ---------- Easing ----------
+// Progress and result are Q16 (0..ONE). Integer only, like FixedGeom.h.
+constexpr int32_t ONE = 1 << 16;
+using Ease = int32_t (*)(int32_t p);
+
+inline int32_t linear(int32_t p) { return p; }
+
+// Decelerates into the target: 1 - (1-p)^3.
+inline int32_t ease_out(int32_t p) {
+  const int64_t q = ONE - p;
+  return ONE - (int32_t)((q * q >> 16) * q >> 16);
+}
+
+// Quadratic in and out.
+inline int32_t ease_in_out(int32_t p) {
+  if (p < ONE / 2) return (int32_t)((int64_t) 2 * p * p >> 16);
+  const int64_t q = ONE - p;
+  return ONE - (int32_t)((int64_t) 2 * q * q >> 16);
+}
+
+} // namespace anim
+
+// ---------- Tween: an integer value easing towards a target over time ----------
+// Time based, so a dropped frame only makes the next step larger. A new
+// target starts from the value currently shown, and the clock starts at the
+// first step() after it, so an update that arrives while the item is not
+// ticking (hidden page, asleep) animates once it is visible.
+class Tween {
+public:
+  explicit Tween(uint16_t duration_ms = 300, anim::Ease ease = anim::ease_out)
+  : dur_(duration_ms), ease_(ease) {}
+
+  void set_duration(uint16_t ms) { dur_ = ms; }
+
+  // Animate to v.
+  void to(int32_t v) {
+    if (v == to_ && (active_ || cur_ == v)) return;
+    from_ = cur_; to_ = v;
+    active_ = dur_ > 0;
+    started_ = false;
+    if (!active_) cur_ = v;
+  }
+
+  // Jump to v without animating.
+  void set(int32_t v) { from_ = to_ = cur_ = v; active_ = false; }
+
+  // Advances to now; returns true if value() changed.
+  bool step(uint32_t now_ms) {
+    if (!active_) return false;
+    if (!started_) { start_ = now_ms; started_ = true; }
+    const uint32_t t = now_ms - start_;
+    const int32_t prev = cur_;
+    if (t >= dur_) {
+      cur_ = to_;
+      active_ = false;
+    } else {
+      const int32_t p = (int32_t)(((uint32_t) t << 16) / dur_);
+      cur_ = from_ + (int32_t)(((int64_t)(to_ - from_) * ease_(p)) >> 16);
+    }
+    return cur_ != prev;
+  }
+
+  int32_t value() const { return cur_; }
+  int32_t target() const { return to_; }
+  bool active() const { return active_; }
+
+private:
+  uint16_t dur_;
+  anim::Ease ease_;
+  int32_t from_{0}, to_{0}, cur_{0};
+  uint32_t start_{0};
+  bool active_{false}, started_{false};
+};
+
+// ---------- FramePacer: fixed frame rate on a loop that runs faster ----------
+// due() is true once per frame period. A step that ran past one or more
+// whole periods does not queue catch-up frames: the missed slots are counted
+// as dropped and the schedule moves on, so a slow frame never causes a burst.
+class FramePacer {
+public:
+  explicit FramePacer(uint32_t fps = 0) { set_fps(fps); }
+
+  // 0 = unpaced (every call is a frame).
+  void set_fps(uint32_t fps) { period_ms_ = fps ? (1000 + fps / 2) / fps : 0; }
+  uint32_t period_ms() const { return period_ms_; }
+
+  bool due(uint32_t now_ms) {
+    if (!period_ms_) return true;
+    if (!started_) { next_ = now_ms; started_ = true; }
+    if ((int32_t)(now_ms - next_) < 0) return false;
+    const uint32_t missed = (now_ms - next_) / period_ms_;
+    dropped_ += missed;
+    next_ += (missed + 1) * period_ms_;
+    return true;
+  }
+
+  // Frames dropped since the last call.
+  uint32_t take_dropped() {
+    const uint32_t n = dropped_;
+    dropped_ = 0;
+    return n;
+  }
+
+private:
+  uint32_t period_ms_{0};
+  uint32_t next_{0};
+  uint32_t dropped_{0};
+  bool started_{false};
+};
+
+} // namespace touch_panel
+
+#endif
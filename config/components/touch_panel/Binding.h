@@ -0,0 +1,81 @@
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "PanelItem.h"
+#include "EnvItem.h"
+#include "ChartItem.h"
+#include "GaugeItem.h"
+
+#ifndef binding_h
+#define binding_h
+
+namespace touch_panel {
+
+// ---------- Binding: an entity's latest value for one item ----------
+// Entity callbacks only record the value (any number of times per frame);
+// the render step hands the latest one to the item once, so a burst of
+// state syncs after a reconnect costs at most one render per item.
+// The constructors take the item type the value makes sense for.
+class Binding {
+public:
+  explicit Binding(ToggleItem* item) : item_(item) {}
+  // Temperature and humidity come from separate sensors.
+  explicit Binding(EnvItem* item) : item_(item), env_(true) {}
+  // Every reading is a sample, even an unchanged one. Sensors publish far
+  // less often than once per frame, so keeping only the latest loses none.
+  explicit Binding(ChartItem* item) : item_(item), chart_(item) {}
+  // Only the latest reading matters; the gauge redraws the arc it moved.
+  explicit Binding(GaugeItem* item) : item_(item), gauge_(item) {}
+
+  // ESPHome loop. Return true if the value differs from the last one recorded.
+  bool set_state(bool on) { return set_(state_, on ? 1 : 0); }
+  bool set_temperature(float t) { return set_(t_, t); }
+  bool set_humidity(float h) { return set_(h_, h); }
+  bool set_sample(float v) {
+    t_.store(v, std::memory_order_relaxed);
+    pending_.store(true, std::memory_order_release);
+    return true;
+  }
+
+  // Render step.
+  void apply() {
+    if (!pending_.exchange(false, std::memory_order_acquire)) return;
+    if (chart_) {
+      chart_->AddSample(t_.load(std::memory_order_relaxed));
+      return;
+    }
+    if (gauge_) {
+      gauge_->SetValue(t_.load(std::memory_order_relaxed));
+      return;
+    }
+    if (env_) {
+      item_->OnEnvUpdate(t_.load(std::memory_order_relaxed), h_.load(std::memory_order_relaxed));
+      return;
+    }
+    const int8_t s = state_.load(std::memory_order_relaxed);
+    if (s >= 0) item_->SetState(s != 0);
+  }
+
+  IPanelItem* item() const { return item_; }
+
+private:
+  IPanelItem* item_;
+  bool env_{false};
+  ChartItem* chart_{nullptr};
+  GaugeItem* gauge_{nullptr};
+  std::atomic<int8_t> state_{-1};
+  std::atomic<float> t_{NAN}, h_{NAN};
+  std::atomic<bool> pending_{false};
+
+  template <typename T, typename V>
+  bool set_(std::atomic<T>& slot, V v) {
+    if (slot.exchange((T) v, std::memory_order_relaxed) == (T) v) return false;
+    pending_.store(true, std::memory_order_release);
+    return true;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
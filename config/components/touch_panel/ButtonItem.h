@@ -4,44 +4,60 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 
-#include "esphome.h"
 #include <TFT_eSPI.h>
-#include <XPT2046_Touchscreen.h>
 
 #include "PanelItem.h"
+#include "Animation.h"
 
 #ifndef buttonItem_h
 #define buttonItem_h
 
 namespace touch_panel {
 
-class ButtonItem : public BaseItem {
+class ButtonItem : public ToggleItem {
 public:
   ButtonItem(const char* id, const char* label, int page=0)
-  : BaseItem(id, page), label_(label) {}
+  : ToggleItem(id, page), label_(label) {
+    SetColorDepth(4);   // flat colours: the default palette has them all
+  }
 
-  void SetState(bool on) {
-    if (on_ != on) { on_ = on; Invalidate(); }
+  // Press feedback: the button sinks in while held and springs back on release.
+  bool OnTouch(const TouchEvent& e) override {
+    if (e.type == TouchType::PRESS) press_.to(PRESS_INSET);
+    else if (e.type == TouchType::RELEASE) press_.to(0);
+    return ToggleItem::OnTouch(e);
   }
-  bool State() const { return on_; }
 
-  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
-    uint16_t fill   = on_ ? TFT_GREEN : TFT_DARKGREY;
-    uint16_t stroke = on_ ? TFT_WHITE : TFT_LIGHTGREY;
+  void Tick(uint32_t now_ms) override {
+    ToggleItem::Tick(now_ms);
+    if (press_.step(now_ms)) Invalidate();
+  }
 
-    spr.fillRoundRect(0, 0, B().w, B().h, 8, fill);
-    spr.drawRoundRect(0, 0, B().w, B().h, 8, stroke);
-    spr.setTextDatum(MC_DATUM);
-    spr.setTextColor(TFT_BLACK, fill);
-    spr.drawString(label_.c_str(), B().w/2, B().h/2, 4);
+  int DrawList(DrawCmd* out, int max) const override {
+    if (max < 3) return 0;
+    const bool on = Shown();
+    const uint16_t fill   = on ? TFT_GREEN : TFT_DARKGREY;
+    const uint16_t stroke = Pending() ? TFT_ORANGE : on ? TFT_WHITE : TFT_LIGHTGREY;
+    const int k = press_.value();
+    const Rect r{k, k, B().w - 2*k, B().h - 2*k};
+    out[0] = {DrawCmd::FILL_ROUND_RECT, r, fill, 0, 8};
+    out[1] = {DrawCmd::STROKE_ROUND_RECT, r, stroke, 0, 8};
+    out[2] = {DrawCmd::TEXT, {0, 0, B().w, B().h}, TFT_BLACK, fill, 0, 4, label_.c_str()};
+    return 3;
+  }
 
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    RenderDrawList(spr);
     return true;
   }
 
 private:
+  static constexpr int PRESS_INSET = 3;   // px
   std::string label_;
-  bool on_{false};
+  Tween press_{80};
 };
 
 
@@ -0,0 +1,236 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <TFT_eSPI.h>
+
+#include "PanelItem.h"
+#include "GlyphAtlas.h"
+
+#ifndef chartItem_h
+#define chartItem_h
+
+namespace touch_panel {
+
+// ---------- ChartItem: sensor history as a min/max column plot ----------
+// One history column per plot pixel, each covering span/width of time and
+// holding the min and max of its samples as int16 in units of the
+// resolution (4 bytes per column; a 150 px plot of 4 h of 30 s samples is
+// 600 B). The plot is kept in a PSRAM sprite in ring order, column k at
+// x = k % width, so a sample redraws one column of it and a new column only
+// moves the ring's start; the window is copied out with two row segments.
+// History and plot survive page switches; only a range change (auto range)
+// or a new cell size redraws all columns.
+class ChartItem : public BaseItem {
+public:
+  ChartItem(const char* id, const char* label, int page=0) : BaseItem(id, page), label_(label) {}
+  ~ChartItem() override { freePlot_(); }
+
+  // Time covered by the plot width.
+  void SetSpan(uint32_t ms) { span_ms_ = std::max<uint32_t>(ms, 1000); }
+  // Fixed value range; NAN for either end scales to the data (grows only).
+  void SetRange(float lo, float hi) { lo_ = lo; hi_ = hi; applyRange_(); }
+  // Smallest step stored, e.g. 0.1 for °C, 1 for ppm (int16 range: +-32767 steps).
+  void SetResolution(float r) {
+    res_ = r > 0 ? r : 0.1f;
+    decimals_ = res_ >= 1 ? 0 : res_ >= 0.1f ? 1 : 2;
+    applyRange_();
+  }
+
+  // 8 or 16 bit only: the plot ring's start is a pixel, not a byte, offset.
+  void SetColorDepth(uint8_t depth) override { BaseItem::SetColorDepth(depth == 16 ? 16 : 8); }
+
+  void SetBounds(const Rect& r) override {
+    BaseItem::SetBounds(r);
+    const int w = plotRect_().w;
+    if (w != (int) cols_.size()) resetHistory_(std::max(w, 1));
+  }
+
+  void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    value_.Prepare(tft, spr.getColorDepth());
+    value_.SetPos(pad + tft.textWidth(label_.c_str(), 2) + 6, pad);
+    Invalidate();
+  }
+
+  // Empty columns scroll in while no samples arrive.
+  void Tick(uint32_t now_ms) override {
+    if (advance_(now_ms)) AddDamage(plotRect_());
+  }
+
+  void AddSample(float v) {
+    if (std::isnan(v)) return;
+    const uint32_t now = millis();
+    if (!started_) { started_ = true; col_t0_ = now; }
+    if (advance_(now)) AddDamage(plotRect_());
+
+    const float q = std::round(v / res_);
+    const int16_t s = (int16_t) std::max(-32767.0f, std::min(32767.0f, q));
+    Col& c = cols_[head_ % cols_.size()];
+    c.lo = std::min(c.lo, s);
+    c.hi = std::max(c.hi, s);
+    stale_ = std::max(stale_, 1);
+    if (fitRange_(s)) AddDamage(plotRect_());
+    // The newest column is always the rightmost.
+    const Rect p = plotRect_();
+    AddDamage({p.x + p.w - 1, p.y, 1, p.h});
+
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%.*f", decimals_, v);
+    Rect changed;
+    if (value_.Set(buf, changed)) AddDamage(changed); else Invalidate();
+  }
+
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    spr.setTextDatum(TL_DATUM);
+    spr.setTextColor(dim, bg);
+    spr.drawString(label_.c_str(), pad, pad, 2);
+    value_.Draw(spr);
+
+    const Rect p = plotRect_();
+    const int w = (int) cols_.size();
+    if (!ensurePlot_(tft, spr)) {
+      // No memory for the plot: draw every column straight into the cell.
+      for (int x = 0; x < w; ++x) drawCol_(spr, p.x + x, p.y, head_ + 1 - w + x);
+      return true;
+    }
+    if (replot_) stale_ = w;
+    for (int k = 0; k < stale_; ++k) {
+      const uint32_t abs = head_ - k;
+      drawCol_(*plot_, abs % w, 0, abs);
+    }
+    stale_ = 0;
+    replot_ = false;
+
+    // Oldest column first: ring [start, w) then [0, start).
+    const int bpp = spr.getColorDepth() / 8;
+    const int start = (head_ + 1) % w;
+    const int ps = plot_->width() * bpp, ds = spr.width() * bpp;
+    const uint8_t* src = (const uint8_t*) plot_->getPointer();
+    uint8_t* dst = (uint8_t*) spr.getPointer() + (p.y * spr.width() + p.x) * bpp;
+    for (int y = 0; y < p.h; ++y, src += ps, dst += ds) {
+      memcpy(dst, src + start * bpp, (w - start) * bpp);
+      memcpy(dst + (w - start) * bpp, src, start * bpp);
+    }
+    return true;
+  }
+
+private:
+  struct Col { int16_t lo, hi; };                   // lo > hi: no samples
+  static constexpr Col EMPTY{INT16_MAX, INT16_MIN};
+
+  static constexpr int pad = 4;
+  static constexpr int headerH = 18;
+  static constexpr uint16_t bg   = TFT_BLACK;
+  static constexpr uint16_t dim  = 0x7BEF;
+  static constexpr uint16_t grid = 0x39E7;
+  static constexpr uint16_t line = TFT_CYAN;
+
+  std::string label_;
+  TextField value_{2, TFT_LIGHTGREY, bg, "-0000.00"};
+  uint32_t span_ms_{4 * 3600 * 1000};
+  float res_{0.1f};
+  int decimals_{1};
+  float lo_{NAN}, hi_{NAN};
+  int32_t qlo_{0}, qhi_{0};                         // range in resolution steps
+  bool auto_{true}, ranged_{false};
+
+  std::vector<Col> cols_;
+  uint32_t head_{0};                                // absolute index of the newest column
+  uint32_t col_t0_{0};                              // when the newest column started
+  bool started_{false};
+  TFT_eSprite* plot_{nullptr};
+  int stale_{0};                                    // newest columns not yet in plot_
+  bool replot_{true};
+
+  Rect plotRect_() const {
+    return {pad, pad + headerH, std::max(1, B().w - 2 * pad), std::max(1, B().h - headerH - 2 * pad)};
+  }
+  uint32_t colMs_() const { return std::max<uint32_t>(1, span_ms_ / cols_.size()); }
+
+  void resetHistory_(int w) {
+    cols_.assign(w, EMPTY);
+    head_ = w - 1;    // keeps every visible column index >= 0
+    started_ = false;
+    replot_ = true;
+  }
+
+  // Starts the columns whose time has begun; true if any did.
+  bool advance_(uint32_t now) {
+    if (!started_) return false;
+    const uint32_t ms = colMs_();
+    const uint32_t n = (now - col_t0_) / ms;
+    if (!n) return false;
+    col_t0_ += n * ms;
+    const uint32_t k = std::min<uint32_t>(n, cols_.size());
+    head_ += n - k;                                 // columns that scrolled straight out
+    for (uint32_t i = 0; i < k; ++i) cols_[++head_ % cols_.size()] = EMPTY;
+    stale_ = std::min<int>(stale_ + k, cols_.size());
+    return true;
+  }
+
+  void applyRange_() {
+    auto_ = std::isnan(lo_) || std::isnan(hi_) || hi_ <= lo_;
+    ranged_ = !auto_;
+    if (!auto_) { qlo_ = std::lround(lo_ / res_); qhi_ = std::lround(hi_ / res_); }
+    replot_ = true;
+    Invalidate();
+  }
+
+  // Auto range: grows around s with some headroom. True if the range changed.
+  bool fitRange_(int16_t s) {
+    if (!auto_) return false;
+    if (ranged_ && s >= qlo_ && s <= qhi_) return false;
+    if (!ranged_) { qlo_ = qhi_ = s; ranged_ = true; }
+    const int32_t m = std::max<int32_t>(10, (std::max<int32_t>(qhi_, s) - std::min<int32_t>(qlo_, s)) / 4);
+    if (s <= qlo_) qlo_ = s - m;
+    if (s >= qhi_) qhi_ = s + m;
+    replot_ = true;
+    return true;
+  }
+
+  int yOf_(int32_t q, int h) const {
+    const int32_t span = std::max<int32_t>(1, qhi_ - qlo_);
+    const int32_t y = (h - 1) - (int32_t)((int64_t)(q - qlo_) * (h - 1) / span);
+    return std::max(0, std::min(h - 1, (int) y));
+  }
+
+  // History column abs at (x, y0) of spr: background, dotted mid line, min..max bar.
+  void drawCol_(TFT_eSprite& spr, int x, int y0, uint32_t abs) {
+    const int h = plotRect_().h;
+    spr.drawFastVLine(x, y0, h, bg);
+    if (abs % 4 == 0) spr.drawPixel(x, y0 + h / 2, grid);
+    const Col& c = cols_[abs % cols_.size()];
+    if (c.lo > c.hi || !ranged_) return;
+    const int top = yOf_(c.hi, h), bot = yOf_(c.lo, h);
+    spr.drawFastVLine(x, y0 + top, bot - top + 1, line);
+  }
+
+  bool ensurePlot_(TFT_eSPI& tft, TFT_eSprite& spr) {
+    const Rect p = plotRect_();
+    const int depth = spr.getColorDepth();
+    if (plot_ && plot_->width() == p.w && plot_->height() == p.h && plot_->getColorDepth() == depth)
+      return true;
+    freePlot_();
+    plot_ = new TFT_eSprite(&tft);
+    plot_->setAttribute(PSRAM_ENABLE, 1);
+    plot_->setColorDepth(depth);
+    if (!plot_->createSprite(p.w, p.h)) { freePlot_(); return false; }
+    replot_ = true;
+    return true;
+  }
+
+  void freePlot_() {
+    if (!plot_) return;
+    plot_->deleteSprite();
+    delete plot_;
+    plot_ = nullptr;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
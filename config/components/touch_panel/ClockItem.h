@@ -4,12 +4,14 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 
-#include "esphome.h"
 #include <TFT_eSPI.h>
-#include <XPT2046_Touchscreen.h>
 
 #include "PanelItem.h"
+#include "FixedGeom.h"
+#include "GlyphAtlas.h"
 
 #ifndef clockItem_h
 #define clockItem_h
@@ -18,126 +20,216 @@ namespace touch_panel {
 
 class ClockItem : public BaseItem {
 public:
-  ClockItem(const char* id="clock", int page=0) : BaseItem(id, page) {}
+  ClockItem(const char* id="clock", int page=0) : BaseItem(id, page) {
+    time_.SetPos(6, 6);
+  }
 
-  void OnTimeUpdate(int hours, int minutes, int seconds) override {
-    if (hours_ == hours && minutes_ == minutes && seconds_ == seconds) return;
-    hours_ = hours; minutes_ = minutes; seconds_ = seconds;    
+  // 8 or 16 bit only: the time text is drawn in RGB565, not palette indices.
+  void SetColorDepth(uint8_t depth) override { BaseItem::SetColorDepth(depth == 16 ? 16 : 8); }
+
+  void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    time_.Prepare(tft, spr.getColorDepth());
+    updateText_();
     Invalidate();
   }
 
-  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
-    spr.setTextDatum(TL_DATUM);
-    spr.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+  TopicMask Topics() const override { return topic_bit(TOPIC_TIME); }
 
-    static int pad = 0;
-    if (pad == 0) pad = spr.textWidth("00:00:00", 4);
-    spr.setTextPadding(pad);
+  void OnTimeUpdate(int hours, int minutes, int seconds) override {
+    if (hours_ == hours && minutes_ == minutes && seconds_ == seconds) return;
+    hours_ = hours; minutes_ = minutes; seconds_ = seconds;
+    updateText_();
+  }
 
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", hours_, minutes_, seconds_);
-    spr.drawString(buf, 6, 6, 4);
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    time_.Draw(spr);
     return true;
   }
 
 private:
   int hours_{0}, minutes_{0}, seconds_{0};
-};
-
-#include <cmath>
+  TextField time_{4, TFT_LIGHTGREY, TFT_BLACK, "00:00:00"};
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+  // Usually only the seconds digits change.
+  void updateText_() {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", hours_, minutes_, seconds_);
+    Rect changed;
+    if (time_.Set(buf, changed)) AddDamage(changed);
+    else Invalidate();
+  }
+};
 
-class AnalogClockItem : public BaseItem {
+class AnalogClockItem : public LayeredItem {
 public:
   AnalogClockItem(const char* id="analog_clock", int page=0)
-  : BaseItem(id, page) {}
+  : LayeredItem(id, page) {}
 
-  void OnTimeUpdate(int hours, int minutes, int seconds) override {
-    if (hours_ == hours && minutes_ == minutes && seconds_ == seconds) return;
-    hours_ = hours; minutes_ = minutes; seconds_ = seconds;
+  // 8 or 16 bit only: ticks, hands and text are RGB565, and a 4-bit sprite
+  // gets no static layer cache.
+  void SetColorDepth(uint8_t depth) override { LayeredItem::SetColorDepth(depth == 16 ? 16 : 8); }
+
+  void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    text_.Prepare(tft, spr.getColorDepth());
+    updateText_();
     Invalidate();
   }
 
-  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
-    const int w = B().w, h = B().h;
-    const int cx = w / 2, cy = h / 2;
-    const int r  = (std::min(w, h) / 2) - 2;
+  TopicMask Topics() const override { return topic_bit(TOPIC_TIME); }
 
-    // palette: quiet + monochrome-ish
-    const uint16_t bg       = TFT_BLACK;
-    const uint16_t ticks    = TFT_WHITE;      // soft grey
-    const uint16_t hourCol  = TFT_WHITE;  // slim, elegant
-    const uint16_t minCol   = TFT_SILVER;
-    const uint16_t secCol   = TFT_RED;      // very light grey (keeps it subtle)
+  void OnTimeUpdate(int hours, int minutes, int seconds) override {
+    if (hours_ == hours && minutes_ == minutes && seconds_ == seconds) return;
+    hours_ = hours; minutes_ = minutes; seconds_ = seconds;
 
-    spr.setTextDatum(TC_DATUM);
-    spr.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
+    // Only the hands that actually moved (plus the text once a minute) need a repaint.
+    Hands now = hands_();
+    updateText_();
+    damageMoved_(drawn_.hour, now.hour);
+    damageMoved_(drawn_.minute, now.minute);
+    damageMoved_(drawn_.second, now.second);
+    drawn_ = now;
+  }
 
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%02d:%02d", hours_, minutes_);
-    spr.drawString(buf, B().w / 2, B().h - B().h / 3, 4);
+  void SetBounds(const Rect& r) override {
+    LayeredItem::SetBounds(r);
+    text_.SetPos(B().w / 2, B().h - B().h / 3);
+    drawn_ = hands_();
+  }
+
+protected:
+  // faint 12 dots (major hours only), 12/3/6/9 slightly larger
+  void RenderStatic(TFT_eSprite& spr) override {
+    const int cx = B().w / 2, cy = B().h / 2;
+    const int r  = radius_();
+    const uint16_t ticks = TFT_WHITE;      // soft grey
 
-    // faint 12 dots (major hours only), 12/3/6/9 slightly larger
     for (int i = 0; i < 12; ++i) {
-      float a = (i / 12.0f) * 2.0f * M_PI;
-      int x, y; polar_(cx, cy, a, r - 6, x, y);
+      int x, y; fx::polar(cx, cy, fx::turn(i, 12), fx::q4(r - 6), x, y);
       int dot = (i % 3 == 0) ? 2 : 1;
       spr.fillCircle(x, y, dot, ticks);
     }
+  }
+
+  void RenderDynamic(TFT_eSprite& spr) override {
+    const int cx = B().w / 2, cy = B().h / 2;
+    const int r  = radius_();
+
+    // palette: quiet + monochrome-ish
+    const uint16_t hourCol  = TFT_WHITE;  // slim, elegant
+    const uint16_t minCol   = TFT_SILVER;
+    const uint16_t secCol   = TFT_RED;      // very light grey (keeps it subtle)
+
+    text_.Draw(spr);
 
     // angles (smooth hour/minute)
-    const float sa = (seconds_ / 60.0f) * 2.0f * M_PI;
-    const float ma = ((minutes_ + seconds_ / 60.0f) / 60.0f) * 2.0f * M_PI;
-    const float ha = (((hours_ % 12) + minutes_ / 60.0f + seconds_ / 3600.0f) / 12.0f) * 2.0f * M_PI;
+    int32_t ha, ma, sa;
+    angles_(ha, ma, sa);
 
     // hands — slim & tapered, no shadows, no tail
-    drawHandTaper_(spr, cx, cy, ha, r * 0.55f, 2, hourCol); // hour (slightly thicker)
-    drawHandTaper_(spr, cx, cy, ma, r * 0.78f, 1, minCol);  // minute
-    drawSecondLine_(spr, cx, cy, sa, r * 0.82f, secCol);    // second (single thin line)
+    drawHandTaper_(spr, cx, cy, ha, hourLen_(r), 2, hourCol); // hour (slightly thicker)
+    drawHandTaper_(spr, cx, cy, ma, minLen_(r), 1, minCol);   // minute
+    drawSecondLine_(spr, cx, cy, sa, secLen_(r), secCol);     // second (single thin line)
 
     // tiny center dot
     spr.fillCircle(cx, cy, 2, hourCol);
-    return true;
   }
 
 private:
   int hours_{0}, minutes_{0}, seconds_{0};
+  TextField text_{4, TFT_LIGHTGREY, TFT_BLACK, "00:00", TC_DATUM};
+
+  // Bounding boxes (item-local) of each hand as last handed to the panel.
+  struct Hands { Rect hour, minute, second; };
+  Hands drawn_{};
+
+  int radius_() const { return (std::min(B().w, B().h) / 2) - 2; }
 
-  static void polar_(int cx, int cy, float a, float rad, int& x, int& y) {
-    x = (int)std::lround(cx + std::sin(a) * rad);
-    y = (int)std::lround(cy - std::cos(a) * rad);
+  // Hand lengths in Q4 (fractions of the dial radius).
+  static int32_t hourLen_(int r) { return fx::q4(r) * 55 / 100; }
+  static int32_t minLen_(int r)  { return fx::q4(r) * 78 / 100; }
+  static int32_t secLen_(int r)  { return fx::q4(r) * 82 / 100; }
+
+  // Binary angles (see FixedGeom.h); hour and minute move smoothly.
+  void angles_(int32_t& ha, int32_t& ma, int32_t& sa) const {
+    sa = fx::turn(seconds_, 60);
+    ma = fx::turn(minutes_ * 60 + seconds_, 3600);
+    ha = fx::turn((hours_ % 12) * 3600 + minutes_ * 60 + seconds_, 12 * 3600);
   }
 
-  // Replace your existing drawHandTaper_ with this:
-  static void drawHandTaper_(TFT_eSprite& spr, int cx, int cy,
-                            float a, float len, int baseW, uint16_t col) {
-    // tip (points to angle a, with your polar_ convention)
-    int xt, yt, xtail, ytail;
-    polar_(cx, cy, a, len, xt, yt);
-    polar_(cx, cy, a, -(len*0.2f), xtail, ytail);
+  Hands hands_() const {
+    const int cx = B().w / 2, cy = B().h / 2;
+    const int r  = radius_();
+    int32_t ha, ma, sa;
+    angles_(ha, ma, sa);
+
+    int p[6];
+    Hands out;
+    taperPoints_(cx, cy, ha, hourLen_(r), 2, p);
+    out.hour = bbox_(p, 3);
+    taperPoints_(cx, cy, ma, minLen_(r), 1, p);
+    out.minute = bbox_(p, 3);
+    p[0] = cx; p[1] = cy;
+    fx::polar(cx, cy, sa, secLen_(r), p[2], p[3]);
+    out.second = bbox_(p, 2);
+    return out;
+  }
 
-    // perpendicular to the hand direction:
-    // direction d = (sin a, -cos a)  -->  perp p = (-dy, dx) = (cos a, sin a)
-    const float s = std::sin(a), c = std::cos(a);
-    const float half = baseW;
+  // The "HH:MM" line below the center; changes once a minute.
+  void updateText_() {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02d:%02d", hours_, minutes_);
+    Rect changed;
+    if (text_.Set(buf, changed)) AddDamage(changed);
+    else Invalidate();
+  }
 
-    // base is centered on (cx, cy), offset +/- perp
-    const int xb1 = (int)std::lround(xtail - c * half);
-    const int yb1 = (int)std::lround(ytail - s * half);
-    const int xb2 = (int)std::lround(xtail + c * half);
-    const int yb2 = (int)std::lround(ytail + s * half);
+  void damageMoved_(const Rect& was, const Rect& is) {
+    if (was.x == is.x && was.y == is.y && was.w == is.w && was.h == is.h) return;
+    AddDamage(was);
+    AddDamage(is);
+  }
 
-    spr.fillTriangle(xb1, yb1, xb2, yb2, xt, yt, col);
+  // Bounding box of n points, padded to cover line width and the center dot.
+  static Rect bbox_(const int* p, int n) {
+    int x0 = p[0], y0 = p[1], x1 = p[0], y1 = p[1];
+    for (int i = 1; i < n; ++i) {
+      x0 = std::min(x0, p[2*i]); x1 = std::max(x1, p[2*i]);
+      y0 = std::min(y0, p[2*i+1]); y1 = std::max(y1, p[2*i+1]);
+    }
+    const int pad = 3;
+    return {x0 - pad, y0 - pad, x1 - x0 + 1 + 2*pad, y1 - y0 + 1 + 2*pad};
+  }
+
+  // Triangle of a tapered hand: two base corners then the tip.
+  static void taperPoints_(int cx, int cy, int32_t a, int32_t len_q4, int baseW, int* p) {
+    // tip, and the tail point 20% behind the center
+    int xt, yt, xtail, ytail;
+    fx::polar(cx, cy, a, len_q4, xt, yt);
+    fx::polar(cx, cy, a, -len_q4 / 5, xtail, ytail);
+
+    // base is centered on the tail, offset +/- perpendicular to the hand
+    int dx, dy;
+    fx::perp(a, fx::q4(baseW), dx, dy);
+    p[0] = xtail - dx;
+    p[1] = ytail - dy;
+    p[2] = xtail + dx;
+    p[3] = ytail + dy;
+    p[4] = xt;
+    p[5] = yt;
+  }
+
+  static void drawHandTaper_(TFT_eSprite& spr, int cx, int cy,
+                            int32_t a, int32_t len_q4, int baseW, uint16_t col) {
+    int p[6];
+    taperPoints_(cx, cy, a, len_q4, baseW, p);
+    spr.fillTriangle(p[0], p[1], p[2], p[3], p[4], p[5], col);
     // Optional: crisp edges
-    // spr.drawTriangle(xb1, yb1, xb2, yb2, xt, yt, col);
+    // spr.drawTriangle(p[0], p[1], p[2], p[3], p[4], p[5], col);
   }
 
 
-  static void drawSecondLine_(TFT_eSprite& spr, int cx, int cy, float a, float len, uint16_t col) {
-    int xs, ys; polar_(cx, cy, a, len, xs, ys);
+  static void drawSecondLine_(TFT_eSprite& spr, int cx, int cy, int32_t a, int32_t len_q4, uint16_t col) {
+    int xs, ys; fx::polar(cx, cy, a, len_q4, xs, ys);
     spr.drawLine(cx, cy, xs, ys, col);
   }
 };
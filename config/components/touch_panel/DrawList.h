@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "PanelItem.h"
+
+#ifndef drawList_h
+#define drawList_h
+
+namespace touch_panel {
+
+// ---------- SolidSplit: a draw list as controller fills plus sprite rects ----------
+// Walks an item's draw commands in paint order and keeps the areas that end
+// up one flat colour: the straight middle band of a filled round rect, or a
+// filled rect, minus whatever a later command paints over them (stroke
+// edges, corner rows, text boxes). Pieces under MIN_SOLID_PX are left to the
+// sprite, where they cost less than another address window. The rest of the
+// cell is handed back as rectangles to push from the sprite.
+class SolidSplit {
+public:
+  struct Fill { Rect r; uint16_t color; };
+
+  static constexpr int MAX_FILLS = 8;
+  static constexpr int MAX_REST = 16;
+  static constexpr int MIN_SOLID_PX = 512;
+  static constexpr int TEXT_PAD = 2;   // px around a measured text box
+
+  // text_box(const DrawCmd&) -> Rect: where a TEXT command paints (item-local).
+  // False if nothing worth a fill was found; the cell is then pushed whole.
+  template <typename TextBox>
+  bool split(const DrawCmd* cmds, int n, int w, int h, TextBox&& text_box) {
+    nf_ = nr_ = 0;
+    const Rect cell{0, 0, w, h};
+    for (int i = 0; i < n; ++i) {
+      const DrawCmd& c = cmds[i];
+      const int rad = std::min<int>(c.radius, std::min(c.r.w, c.r.h) / 2);
+      switch (c.kind) {
+        case DrawCmd::FILL_RECT:
+          carve_(c.r);
+          add_(intersect(c.r, cell), c.color);
+          break;
+        case DrawCmd::FILL_ROUND_RECT:
+          carve_(c.r);
+          add_(intersect({c.r.x, c.r.y + rad, c.r.w, c.r.h - 2 * rad}, cell), c.color);
+          break;
+        case DrawCmd::STROKE_ROUND_RECT:
+          carve_({c.r.x, c.r.y, c.r.w, std::max(rad, 1)});
+          carve_({c.r.x, c.r.y + c.r.h - std::max(rad, 1), c.r.w, std::max(rad, 1)});
+          carve_({c.r.x, c.r.y, 1, c.r.h});
+          carve_({c.r.x + c.r.w - 1, c.r.y, 1, c.r.h});
+          break;
+        case DrawCmd::TEXT: {
+          const Rect t = text_box(c);
+          carve_({t.x - TEXT_PAD, t.y - TEXT_PAD, t.w + 2 * TEXT_PAD, t.h + 2 * TEXT_PAD});
+          break;
+        }
+      }
+    }
+    if (!nf_) return false;
+    return rest_(w, h);
+  }
+
+  int fills() const { return nf_; }
+  const Fill& fill(int i) const { return fills_[i]; }
+  int rests() const { return nr_; }
+  const Rect& rest(int i) const { return rest_r_[i]; }
+
+  uint32_t solid_px() const {
+    uint32_t px = 0;
+    for (int i = 0; i < nf_; ++i) px += (uint32_t) fills_[i].r.w * fills_[i].r.h;
+    return px;
+  }
+
+private:
+  Fill fills_[MAX_FILLS];
+  Rect rest_r_[MAX_REST];
+  int nf_{0}, nr_{0};
+
+  void add_(const Rect& r, uint16_t color) {
+    if (empty(r) || r.w * r.h < MIN_SOLID_PX) return;
+    if (nf_ == MAX_FILLS) {
+      // Keep the larger pieces; the smallest falls back to the sprite.
+      int k = 0;
+      for (int i = 1; i < nf_; ++i) if (fills_[i].r.w * fills_[i].r.h < fills_[k].r.w * fills_[k].r.h) k = i;
+      if (fills_[k].r.w * fills_[k].r.h >= r.w * r.h) return;
+      fills_[k] = fills_[--nf_];
+    }
+    fills_[nf_++] = {r, color};
+  }
+
+  // Removes o from every fill; what is left of a fill is up to four rects.
+  void carve_(const Rect& o) {
+    if (empty(o)) return;
+    Fill old[MAX_FILLS];
+    const int n = nf_;
+    std::copy(fills_, fills_ + n, old);
+    nf_ = 0;
+    for (int i = 0; i < n; ++i) {
+      const Rect& r = old[i].r;
+      const Rect c = intersect(r, o);
+      if (empty(c)) { add_(r, old[i].color); continue; }
+      add_({r.x, r.y, r.w, c.y - r.y}, old[i].color);                          // above
+      add_({r.x, c.y + c.h, r.w, r.y + r.h - c.y - c.h}, old[i].color);        // below
+      add_({r.x, c.y, c.x - r.x, c.h}, old[i].color);                          // left
+      add_({c.x + c.w, c.y, r.x + r.w - c.x - c.w, c.h}, old[i].color);        // right
+    }
+  }
+
+  // The cell minus the fills, as horizontal bands of x-intervals.
+  bool rest_(int w, int h) {
+    int ys[2 * MAX_FILLS + 2];
+    int ny = 0;
+    ys[ny++] = 0; ys[ny++] = h;
+    for (int i = 0; i < nf_; ++i) { ys[ny++] = fills_[i].r.y; ys[ny++] = fills_[i].r.y + fills_[i].r.h; }
+    std::sort(ys, ys + ny);
+    ny = std::unique(ys, ys + ny) - ys;
+
+    for (int b = 0; b + 1 < ny; ++b) {
+      const int y0 = ys[b], y1 = ys[b + 1];
+      // x-intervals covered by fills spanning this band, sorted by x.
+      struct Span { int x0, x1; } xs[MAX_FILLS];
+      int nx = 0;
+      for (int i = 0; i < nf_; ++i) {
+        const Rect& r = fills_[i].r;
+        if (r.y <= y0 && r.y + r.h >= y1) xs[nx++] = {r.x, r.x + r.w};
+      }
+      std::sort(xs, xs + nx, [](const Span& a, const Span& b){ return a.x0 < b.x0; });
+      int x = 0;
+      for (int k = 0; k <= nx; ++k) {
+        const int x1 = k < nx ? xs[k].x0 : w;
+        if (x1 > x && !push_rest_({x, y0, x1 - x, y1 - y0})) return false;
+        if (k < nx) x = std::max(x, xs[k].x1);
+      }
+    }
+    return true;
+  }
+
+  // Appends r, or grows the rect above that r continues straight down.
+  bool push_rest_(const Rect& r) {
+    for (int i = 0; i < nr_; ++i) {
+      Rect& p = rest_r_[i];
+      if (p.x == r.x && p.w == r.w && p.y + p.h == r.y) { p.h += r.h; return true; }
+    }
+    if (nr_ == MAX_REST) return false;
+    rest_r_[nr_++] = r;
+    return true;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
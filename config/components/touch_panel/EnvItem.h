@@ -4,142 +4,199 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 
-#include "esphome.h"
 #include <TFT_eSPI.h>
-#include <XPT2046_Touchscreen.h>
 
 #include "PanelItem.h"
+#include "FixedGeom.h"
+#include "GlyphAtlas.h"
+#include "Animation.h"
 
 #ifndef envItem_h
 #define envItem_h
 
 namespace touch_panel {
 
-class EnvItem : public BaseItem {
+class EnvItem : public LayeredItem {
 public:
-  EnvItem(const char* id="env", int page=0) : BaseItem(id, page) {}
+  EnvItem(const char* id="env", int page=0) : LayeredItem(id, page) {
+    SetColorDepth(16);   // deep grey, red and blue fills band badly in RGB332
+    temp_.SetPos(iconX + 30, pad + 11);
+  }
+
+  // 8 or 16 bit only: icons, bars and text are RGB565, and a 4-bit sprite
+  // gets no static layer cache.
+  void SetColorDepth(uint8_t depth) override { LayeredItem::SetColorDepth(depth == 16 ? 16 : 8); }
+
+  void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    temp_.Prepare(tft, spr.getColorDepth());
+    hum_.Prepare(tft, spr.getColorDepth());
+    updateText_();
+    Invalidate();
+  }
+
+  void SetBounds(const Rect& r) override {
+    LayeredItem::SetBounds(r);
+    hum_.SetPos(iconX + 30, B().h/2 + pad + 6);
+  }
+
+  TopicMask Topics() const override { return topic_bit(TOPIC_ENV); }
 
   void OnEnvUpdate(float t, float h) override {
-    if (isnan(t) || isnan(h)) return;
-    if (fabsf(t - t_) > 0.05f || fabsf(h - h_) > 0.5f) {
-      t_ = t; h_ = h; Invalidate();
+    if (std::isnan(t) || std::isnan(h)) return;
+    if (std::fabs(t - t_) > 0.05f || std::fabs(h - h_) > 0.5f) {
+      t_ = t; h_ = h;
+      // Fill levels work in tenths (°C, %) so rendering needs no float math.
+      t10_ = (int32_t)(t * 10.0f + (t >= 0 ? 0.5f : -0.5f));
+      h10_ = (int32_t)(h * 10.0f + (h >= 0 ? 0.5f : -0.5f));
+      // Text changes at once; the fills ease to their new level in Tick().
+      tFill_.to(t10_);
+      hFill_.to(h10_);
+      updateText_();
     }
   }
 
-  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
-    // --- layout ---
-    const int w = B().w, h = B().h;
-    const int pad = 6;
-
-    // --- palette / colors (subtle theme) ---
-    const uint16_t bg        = TFT_BLACK;
-    const uint16_t cardFill  = 0x2104;      // deep grey
-    const uint16_t ink       = TFT_SILVER;  // text
-    const uint16_t tickDim   = 0x7BEF;
-
-    const uint16_t thermoOut = tickDim;
-    const uint16_t thermoFill= 0xF900;      // red
-    const uint16_t dropOut   = tickDim;
-    const uint16_t dropFill  = 0x003F;      // blue
-
-    // --- thermometer icon (top row) ---
-    // Normalize temp to [-10..40]°C range for fill level
-    const float tMin = -10.0f, tMax = 40.0f;
-    float tPct = (t_ - tMin) / (tMax - tMin);
-    if (tPct < 0) tPct = 0; if (tPct > 1) tPct = 1;
-
-    int iconX = pad + 7;
-    int iconY = pad + 2;
-    drawThermometer_(spr, iconX, iconY, /*stemH*/28, /*stemW*/10, /*bulbR*/8, thermoOut, thermoFill, tPct);
-
-    // temperature text
-    spr.setTextDatum(TL_DATUM);
-    spr.setTextColor(ink, bg);
-    static int tpad = 0;
-    if (!tpad) tpad = spr.textWidth("-00.0°C", 4);
-    spr.setTextPadding(tpad);
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%.1f°C", t_);
-    spr.drawString(buf, iconX + 30, pad + 11, 4);
+  // The fills are small; damage only the one whose level moved by a pixel.
+  void Tick(uint32_t now_ms) override {
+    if (tFill_.step(now_ms)) {
+      const int l = thermoLevel_(tFill_.value());
+      if (l != tLevel_) { tLevel_ = l; AddDamage({iconX, iconY, 17, 48}); }
+    }
+    if (hFill_.step(now_ms)) {
+      const int l = dropLevel_(hFill_.value());
+      if (l != hLevel_) { hLevel_ = l; AddDamage({dropX, dropY_(), 34, 36}); }
+    }
+  }
 
-    // --- droplet icon (bottom row) ---
-    float hPct = h_ / 100.0f;
-    if (hPct < 0) hPct = 0; if (hPct > 1) hPct = 1;
+protected:
+  // --- layout ---
+  static constexpr int pad = 6;
+  static constexpr int iconX = pad + 7;
+  static constexpr int iconY = pad + 2;
+  static constexpr int dropX = pad - 3;
+  int dropY_() const { return B().h/2 + pad; }
+  static constexpr int thermoH = 28;
+  static constexpr int dropSize = 34;
+
+  // Fill levels in pixels. Temperature spans -10..40 °C.
+  static int thermoLevel_(int32_t t10) { return fx::scale_clamped(t10, -100, 400, thermoH - 2); }
+  static int dropLevel_(int32_t h10) { return fx::scale_clamped(h10, 0, 1000, dropSize - 2); }
+
+  // --- palette / colors (subtle theme) ---
+  static constexpr uint16_t bg        = TFT_BLACK;
+  static constexpr uint16_t cardFill  = 0x2104;      // deep grey
+  static constexpr uint16_t ink       = TFT_SILVER;  // text
+  static constexpr uint16_t tickDim   = 0x7BEF;
+
+  static constexpr uint16_t thermoOut = tickDim;
+  static constexpr uint16_t thermoFill= 0xF900;      // red
+  static constexpr uint16_t dropOut   = tickDim;
+  static constexpr uint16_t dropFill  = 0x003F;      // blue
+
+  // Icon outlines only depend on the cell size.
+  void RenderStatic(TFT_eSprite& spr) override {
+    drawThermometerOutline_(spr, iconX, iconY, /*stemH*/28, /*stemW*/10, /*bulbR*/8, thermoOut);
+    drawDropletOutline_(spr, dropX, dropY_(), /*size*/34, dropOut);
+  }
 
-    int dropX = pad - 3;
-    int dropY = h/2 + pad;
-    drawDroplet_(spr, dropX, dropY, /*size*/34, dropOut, dropFill, hPct);
+  void RenderDynamic(TFT_eSprite& spr) override {
+    // --- thermometer fill (top row) ---
+    fillThermometer_(spr, iconX, iconY, thermoH, /*stemW*/10, /*bulbR*/8, thermoFill, tLevel_);
 
-    // humidity text
-    static int hpad_txt = 0;
-    if (!hpad_txt) hpad_txt = spr.textWidth("100%", 4);
-    spr.setTextPadding(hpad_txt);
-    snprintf(buf, sizeof(buf), "%.0f%%", h_);
-    spr.drawString(buf, iconX + 30, h/2 + pad + 6, 4);
+    temp_.Draw(spr);
+
+    // --- droplet fill (bottom row) ---
+    fillDroplet_(spr, dropX, dropY_(), dropSize, dropOut, dropFill, hLevel_);
 
-    return true;
+    hum_.Draw(spr);
   }
 
 private:
   float t_{0}, h_{0};
+  int32_t t10_{0}, h10_{0};
+  Tween tFill_{400}, hFill_{400};       // shown levels, tenths
+  int tLevel_{thermoLevel_(0)}, hLevel_{0};
+  TextField temp_{4, ink, bg, "-00.0°C"};
+  TextField hum_{4, ink, bg, "100%"};
+
+  void updateText_() {
+    char buf[32];
+    Rect changed;
+    snprintf(buf, sizeof(buf), "%.1f°C", t_);
+    if (temp_.Set(buf, changed)) AddDamage(changed); else Invalidate();
+    snprintf(buf, sizeof(buf), "%.0f%%", h_);
+    if (hum_.Set(buf, changed)) AddDamage(changed); else Invalidate();
+  }
 
   // --- ICON HELPERS ---
+  // (x,y) is top-left of the icon bounding box for all helpers.
 
-  // Simple thermometer with outline + variable-level fill.
-  // (x,y) is top-left of the icon bounding box.
-  static void drawThermometer_(TFT_eSprite& spr, int x, int y, int stemH, int stemW, int bulbR,
-                               uint16_t outlineCol, uint16_t fillCol, float pct)
+  // Thermometer outline: rounded stem + bulb.
+  static void drawThermometerOutline_(TFT_eSprite& spr, int x, int y, int stemH, int stemW, int bulbR,
+                                      uint16_t outlineCol)
   {
     // Geometry
     const int cx = x + bulbR;                    // center X
     const int stemX = cx - stemW/2;
     const int stemY = y + 2;
-    const int stemHclamped = stemH;
-    const int bulbCx = cx;
-    const int bulbCy = stemY + stemHclamped + bulbR - 1;
+    const int bulbCy = stemY + stemH + bulbR - 1;
 
-    // Outline
-    spr.drawRoundRect(stemX, stemY, stemW, stemHclamped, stemW/2, outlineCol);
-    spr.drawCircle(bulbCx, bulbCy-2, bulbR, outlineCol);
+    spr.drawRoundRect(stemX, stemY, stemW, stemH, stemW/2, outlineCol);
+    spr.drawCircle(cx, bulbCy-2, bulbR, outlineCol);
+  }
+
+  // Variable-level fill inside the outline, from the bulb up into the stem.
+  // level is in pixels, 0..stemH-2.
+  static void fillThermometer_(TFT_eSprite& spr, int x, int y, int stemH, int stemW, int bulbR,
+                               uint16_t fillCol, int level)
+  {
+    const int cx = x + bulbR;
+    const int stemX = cx - stemW/2;
+    const int stemY = y + 2;
+    const int bulbCy = stemY + stemH + bulbR - 1;
 
-    // Fill level (from bulb up into stem)
-    int level = (int)std::round(pct * (stemHclamped - 2));
-    if (level < 0) level = 0;
     // bulb fill
-    spr.fillCircle(bulbCx, bulbCy-2, bulbR-2, fillCol);
+    spr.fillCircle(cx, bulbCy-2, bulbR-2, fillCol);
     // stem fill (upwards)
-    spr.fillRect(stemX + 2, stemY + stemHclamped - level, stemW - 4, level, fillCol);
+    spr.fillRect(stemX + 2, stemY + stemH - level, stemW - 4, level, fillCol);
 
     // small highlight
-    spr.drawLine(stemX + stemW - 3, stemY + 3, stemX + stemW - 3, stemY + stemHclamped - 3, 0xC618);
+    spr.drawLine(stemX + stemW - 3, stemY + 3, stemX + stemW - 3, stemY + stemH - 3, 0xC618);
+  }
+
+  // Minimal droplet: circle + top “teardrop” tip; size ~ height.
+  static void drawDropletOutline_(TFT_eSprite& spr, int x, int y, int size, uint16_t outlineCol)
+  {
+    const int cx = x + size/2;
+    const int cy = y + size/2 + 2;
+    const int r  = size/3;
+
+    spr.drawCircle(cx, cy, r, outlineCol);
+    spr.drawLine(cx, cy - r - (r/2), cx - r/2, cy - r/4, outlineCol);
+    spr.drawLine(cx, cy - r - (r/2), cx + r/2, cy - r/4, outlineCol);
   }
 
-  // Minimal droplet: circle + top “teardrop” tip; fill level mask using a rect.
-  // (x,y) is top-left of the icon box; size ~ height.
-  static void drawDroplet_(TFT_eSprite& spr, int x, int y, int size,
-                           uint16_t outlineCol, uint16_t fillCol, float pct)
+  // Liquid level: the shape inset by one pixel, clipped to the rows below the level
+  // so the cached outline underneath stays intact. depth is in pixels, 0..size-2.
+  static void fillDroplet_(TFT_eSprite& spr, int x, int y, int size,
+                           uint16_t outlineCol, uint16_t fillCol, int depth)
   {
     const int w = size, h = size;
     const int cx = x + w/2;
     const int cy = y + h/2 + 2;
     const int r  = w/3;
 
-    // Base filled shape: circle + triangle tip
-    spr.fillCircle(cx, cy, r, fillCol);
-    // tip triangle (points upward)
-    spr.fillTriangle(cx, cy - r - (r/2),  cx - r/2, cy - r/4,  cx + r/2, cy - r/4, fillCol);
-
-    // “level” cut: draw a rectangle in background color above the current level to simulate liquid level.
-    // We assume sprite background is already the card color; sample a pixel for safety.
-    uint16_t bg = spr.readPixel(0,0);
-    int levelY = y + (int)std::round((1.0f - pct) * (h - 2)); // higher pct => lower cut
-    spr.fillRect(x, y, w, std::max(0, levelY - y), bg);
+    int levelY = y + (h - 2) - depth; // deeper => lower cut
+    if (levelY < y + h) {
+      spr.setViewport(x, levelY, w, y + h - levelY, false);
+      spr.fillCircle(cx, cy, r - 1, fillCol);
+      spr.fillTriangle(cx, cy - r - (r/2) + 2,  cx - r/2 + 1, cy - r/4,  cx + r/2 - 1, cy - r/4, fillCol);
+      spr.resetViewport();
+    }
 
-    // Outline over top
-    spr.drawCircle(cx, cy, r, outlineCol);
-    spr.drawLine(cx, cy - r - (r/2), cx - r/2, cy - r/4, outlineCol);
-    spr.drawLine(cx, cy - r - (r/2), cx + r/2, cy - r/4, outlineCol);
+    // base of the tip, drawn over the liquid
     spr.drawLine(cx - r/2, cy - r/4, cx + r/2, cy - r/4, outlineCol);
 
     // small inner highlight
@@ -0,0 +1,83 @@
+#include <vector>
+#include <cstdint>
+
+#include "PanelItem.h"
+
+#ifndef eventBus_h
+#define eventBus_h
+
+namespace touch_panel {
+
+// ---------- EventBus: panel-wide broadcasts by topic, deferred per page ----------
+// Items subscribe to the topics they consume (IPanelItem::Topics()). A publish
+// reaches only subscribers on the visible page; every other page keeps just
+// the fact that it missed the latest value and is caught up in page_shown().
+// Runs on the render step only.
+class EventBus {
+public:
+  void subscribe(IPanelItem* item, int page) {
+    const TopicMask m = item->Topics();
+    if (!m || page < 0) return;
+    for (int t = 0; t < TOPIC_COUNT; ++t) {
+      if (!(m & topic_bit(Topic(t)))) continue;
+      auto& pages = subs_[t];
+      if ((size_t) page >= pages.size()) pages.resize(page + 1);
+      pages[page].items.push_back(item);
+      // A late subscriber still gets the current value when its page shows.
+      pages[page].seen = 0;
+    }
+  }
+
+  void publish_time(int h, int m, int s, int visible_page) {
+    time_ = {h, m, s};
+    publish_(TOPIC_TIME, visible_page);
+  }
+
+  void publish_env(float t, float h, int visible_page) {
+    env_ = {t, h};
+    publish_(TOPIC_ENV, visible_page);
+  }
+
+  // Brings page p up to date with every topic it missed while hidden.
+  void page_shown(int p) {
+    for (int t = 0; t < TOPIC_COUNT; ++t) {
+      Page* pg = page_(Topic(t), p);
+      if (pg && seq_[t] && pg->seen != seq_[t]) deliver_(Topic(t), *pg);
+    }
+  }
+
+private:
+  struct Page {
+    std::vector<IPanelItem*> items;
+    uint32_t seen{0};   // seq_ of the last value delivered
+  };
+  std::vector<Page> subs_[TOPIC_COUNT];
+  uint32_t seq_[TOPIC_COUNT]{};
+
+  struct { int h, m, s; } time_{};
+  struct { float t, h; } env_{};
+
+  Page* page_(Topic t, int p) {
+    return (p >= 0 && (size_t) p < subs_[t].size()) ? &subs_[t][p] : nullptr;
+  }
+
+  void publish_(Topic t, int visible_page) {
+    ++seq_[t];
+    if (Page* pg = page_(t, visible_page)) deliver_(t, *pg);
+  }
+
+  void deliver_(Topic t, Page& pg) {
+    pg.seen = seq_[t];
+    for (IPanelItem* it : pg.items) {
+      switch (t) {
+        case TOPIC_TIME: it->OnTimeUpdate(time_.h, time_.m, time_.s); break;
+        case TOPIC_ENV:  it->OnEnvUpdate(env_.t, env_.h); break;
+        default: break;
+      }
+    }
+  }
+};
+
+} // namespace touch_panel
+
+#endif
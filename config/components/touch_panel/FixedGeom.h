@@ -0,0 +1,96 @@
+#include <cstdint>
+
+#ifndef fixedGeom_h
+#define fixedGeom_h
+
+namespace touch_panel {
+namespace fx {
+
+// ---------- Fixed-point geometry ----------
+// Angles are binary angle units: ANGLE_FULL per turn, 0 = 12 o'clock,
+// increasing clockwise (the clock convention used by all items).
+// Sines are Q15, lengths passed to polar() are Q4 (1/16 px).
+
+constexpr int ANGLE_BITS    = 12;
+constexpr int ANGLE_FULL    = 1 << ANGLE_BITS;    // 4096 per turn, ~0.088 deg
+constexpr int ANGLE_QUARTER = ANGLE_FULL / 4;
+constexpr int Q15_ONE       = 32767;
+constexpr int LEN_SHIFT     = 4;                  // Q4 lengths
+
+// Quarter-wave table generated at compile time (Taylor series, |err| < 1 LSB).
+struct SinTable { int16_t v[ANGLE_QUARTER + 1]; };
+
+constexpr double sin_taylor_(double x) {
+  double term = x, sum = x;
+  for (int n = 1; n < 12; ++n) {
+    term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr SinTable make_sin_table_() {
+  SinTable t{};
+  for (int i = 0; i <= ANGLE_QUARTER; ++i) {
+    const double a = (3.14159265358979323846 / 2.0) * i / ANGLE_QUARTER;
+    t.v[i] = (int16_t)(sin_taylor_(a) * Q15_ONE + 0.5);
+  }
+  return t;
+}
+
+constexpr SinTable SIN_TABLE = make_sin_table_();
+static_assert(SIN_TABLE.v[0] == 0 && SIN_TABLE.v[ANGLE_QUARTER] == Q15_ONE, "sine table endpoints");
+
+inline int32_t sin_q15(int32_t a) {
+  a &= ANGLE_FULL - 1;
+  const int q = a >> (ANGLE_BITS - 2);
+  const int i = a & (ANGLE_QUARTER - 1);
+  switch (q) {
+    case 0:  return  SIN_TABLE.v[i];
+    case 1:  return  SIN_TABLE.v[ANGLE_QUARTER - i];
+    case 2:  return -SIN_TABLE.v[i];
+    default: return -SIN_TABLE.v[ANGLE_QUARTER - i];
+  }
+}
+
+inline int32_t cos_q15(int32_t a) { return sin_q15(a + ANGLE_QUARTER); }
+
+// num/den of a turn, e.g. turn(seconds, 60).
+constexpr int32_t turn(int32_t num, int32_t den) {
+  return (int32_t)(((int64_t) num * ANGLE_FULL) / den);
+}
+
+// Pixels to Q4, e.g. q4(r) * 55 / 100 for 0.55 r.
+constexpr int32_t q4(int32_t px) { return px << LEN_SHIFT; }
+
+// Rounded integer division (b > 0).
+constexpr int32_t div_round(int32_t a, int32_t b) {
+  return a >= 0 ? (a + b / 2) / b : -((-a + b / 2) / b);
+}
+
+// Round a Q15 * Q4 product back to pixels.
+inline int32_t q19_to_px_(int32_t v) { return div_round(v, 1 << (15 + LEN_SHIFT)); }
+
+// Point at angle a and distance len_q4 from (cx, cy); y grows downwards.
+inline void polar(int cx, int cy, int32_t a, int32_t len_q4, int& x, int& y) {
+  x = cx + q19_to_px_(sin_q15(a) * len_q4);
+  y = cy - q19_to_px_(cos_q15(a) * len_q4);
+}
+
+// Offset perpendicular to angle a (clockwise), used for the width of hands.
+inline void perp(int32_t a, int32_t len_q4, int& dx, int& dy) {
+  dx = q19_to_px_(cos_q15(a) * len_q4);
+  dy = q19_to_px_(sin_q15(a) * len_q4);
+}
+
+// v in [lo, hi] mapped to [0, span] with rounding and clamping.
+inline int32_t scale_clamped(int32_t v, int32_t lo, int32_t hi, int32_t span) {
+  if (v <= lo) return 0;
+  if (v >= hi) return span;
+  return div_round((v - lo) * span, hi - lo);
+}
+
+} // namespace fx
+} // namespace touch_panel
+
+#endif
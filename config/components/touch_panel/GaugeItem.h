@@ -0,0 +1,263 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <TFT_eSPI.h>
+
+#include "PanelItem.h"
+#include "FixedGeom.h"
+#include "GlyphAtlas.h"
+
+#ifndef gaugeItem_h
+#define gaugeItem_h
+
+namespace touch_panel {
+
+// ---------- GaugeItem: a sensor value on a 270° arc ----------
+// The arc runs clockwise from 7:30 to 4:30 and lives in a PSRAM sprite that
+// survives between updates. Its rows come from span tables built once per
+// cell size (outer and inner half-width of the ring per row, integer square
+// roots); a wedge is cut from each row by the half-planes of its two bounding
+// rays, so drawing costs one sine table lookup per ray and no trig per pixel.
+// A new value redraws only the wedge between the old and the new angle in the
+// arc sprite and damages that wedge's box plus the digits that changed.
+class GaugeItem : public BaseItem {
+public:
+  GaugeItem(const char* id, const char* label, int page=0) : BaseItem(id, page), label_(label) {
+    SetRange(0, 100);
+  }
+  ~GaugeItem() override { freeArc_(); }
+
+  // Values outside the range pin the arc to its ends.
+  void SetRange(float lo, float hi) {
+    lo_ = lo;
+    hi_ = hi > lo ? hi : lo + 1;
+    updateWidest_();
+    shown_ = angleOf_(v_);
+    redraw_ = true;
+    Invalidate();
+  }
+  // Smallest step shown, e.g. 1 for ppm and rpm, 0.1 for °C.
+  void SetResolution(float r) {
+    decimals_ = r >= 1 ? 0 : r >= 0.1f ? 1 : 2;
+    updateWidest_();
+    updateText_();
+  }
+
+  // 8 or 16 bit only: the arc sprite is copied into the cell row by row.
+  void SetColorDepth(uint8_t depth) override { BaseItem::SetColorDepth(depth == 16 ? 16 : 8); }
+
+  void SetBounds(const Rect& r) override {
+    BaseItem::SetBounds(r);
+    layout_();
+  }
+
+  void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    value_.Prepare(tft, spr.getColorDepth());
+    Invalidate();
+  }
+
+  void SetValue(float v) {
+    if (std::isnan(v)) return;
+    v_ = v;
+    const int32_t a = angleOf_(v);
+    if (a != shown_) {
+      AddDamage(wedgeBox_(std::min(a, shown_), std::max(a, shown_)));
+      shown_ = a;
+    }
+    updateText_();
+  }
+
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    const int ax = cx_ - R_, ay = cy_ - R_;
+    if (!ensureArc_(tft, spr)) {
+      // No memory for the arc: draw all of it straight into the cell.
+      drawWedge_(spr, ax, ay, START, shown_, arcOn);
+      drawWedge_(spr, ax, ay, shown_, START + SWEEP, arcOff);
+    } else {
+      if (redraw_) {
+        drawWedge_(*arc_, 0, 0, START, shown_, arcOn);
+        drawWedge_(*arc_, 0, 0, shown_, START + SWEEP, arcOff);
+      } else if (shown_ > drawn_) {
+        drawWedge_(*arc_, 0, 0, drawn_, shown_, arcOn);
+      } else if (shown_ < drawn_) {
+        drawWedge_(*arc_, 0, 0, shown_, drawn_, arcOff);
+      }
+      drawn_ = shown_;
+      redraw_ = false;
+
+      const int bpp = spr.getColorDepth() / 8;
+      const int w = std::min<int>(arc_->width(), spr.width() - ax);
+      const int h = std::min<int>(arc_->height(), spr.height() - ay);
+      const int as = arc_->width() * bpp, ds = spr.width() * bpp;
+      const uint8_t* src = (const uint8_t*) arc_->getPointer();
+      uint8_t* dst = (uint8_t*) spr.getPointer() + (ay * spr.width() + ax) * bpp;
+      for (int y = 0; y < h; ++y, src += as, dst += ds) memcpy(dst, src, w * bpp);
+    }
+
+    value_.Draw(spr);
+    spr.setTextDatum(TC_DATUM);
+    spr.setTextColor(dim, bg);
+    spr.drawString(label_.c_str(), cx_, labelY_, 2);
+    return true;
+  }
+
+private:
+  static constexpr int32_t START = -3 * fx::ANGLE_FULL / 8;   // 7:30
+  static constexpr int32_t SWEEP = 3 * fx::ANGLE_FULL / 4;    // 270°
+  static constexpr int pad = 4;
+
+  static constexpr uint16_t bg     = TFT_BLACK;
+  static constexpr uint16_t dim    = 0x7BEF;
+  static constexpr uint16_t arcOff = 0x2104;   // deep grey track
+  static constexpr uint16_t arcOn  = TFT_CYAN;
+
+  std::string label_;
+  char widest_[16]{};
+  TextField value_{4, TFT_WHITE, bg, widest_, TC_DATUM};
+  int labelY_{0};
+  float lo_{0}, hi_{100};
+  float v_{NAN};
+  int decimals_{0};
+
+  // Geometry, from layout_(): centre, outer radius, ring rows.
+  int cx_{0}, cy_{0}, R_{0};
+  std::vector<int16_t> outer_;   // half-width of the outer circle, per |dy|
+  std::vector<int16_t> inner_;   // half-width of the hole, per |dy|; -1 below/above it
+
+  TFT_eSprite* arc_{nullptr};
+  int32_t shown_{START};         // angle of the current value
+  int32_t drawn_{START};         // angle the arc sprite shows
+  bool redraw_{true};            // arc sprite needs all of the arc
+
+  int32_t angleOf_(float v) const {
+    if (std::isnan(v)) return START;
+    const float f = std::max(0.0f, std::min(1.0f, (v - lo_) / (hi_ - lo_)));
+    return START + (int32_t) std::lround(f * SWEEP);
+  }
+
+  static int isqrt_(int n) {
+    if (n <= 0) return 0;
+    int r = (int) std::sqrt((float) n);
+    while (r * r > n) --r;
+    while ((r + 1) * (r + 1) <= n) ++r;
+    return r;
+  }
+
+  void layout_() {
+    const int w = B().w - 2 * pad, h = B().h - 2 * pad;
+    // The arc's ends sit 0.71 R below the centre, so it is 1.71 R tall.
+    R_ = std::max(8, std::min(w / 2, h * 100 / 171));
+    const int r = R_ - std::max(4, R_ / 5);
+    cx_ = B().w / 2;
+    cy_ = pad + R_ + (h - R_ * 171 / 100) / 2;
+    outer_.resize(R_ + 1);
+    inner_.resize(R_ + 1);
+    for (int d = 0; d <= R_; ++d) {
+      outer_[d] = (int16_t) isqrt_(R_ * R_ - d * d);
+      inner_[d] = (int16_t)(d <= r ? isqrt_(r * r - d * d) : -1);
+    }
+    value_.SetPos(cx_, cy_ - 18);
+    labelY_ = cy_ + 10;
+    redraw_ = true;
+  }
+
+  // Box (item-local) of the ring between angles a0 < a1: the ends of both
+  // rays plus any of the four axis points the sweep passes.
+  Rect wedgeBox_(int32_t a0, int32_t a1) const {
+    const int r = R_ - std::max(4, R_ / 5);
+    int x0 = INT16_MAX, y0 = INT16_MAX, x1 = INT16_MIN, y1 = INT16_MIN;
+    auto add = [&](int32_t a, int len) {
+      int x, y;
+      fx::polar(cx_, cy_, a, fx::q4(len), x, y);
+      x0 = std::min(x0, x); x1 = std::max(x1, x);
+      y0 = std::min(y0, y); y1 = std::max(y1, y);
+    };
+    add(a0, R_); add(a0, r); add(a1, R_); add(a1, r);
+    for (int32_t q = (a0 / fx::ANGLE_QUARTER - 1) * fx::ANGLE_QUARTER; q < a1; q += fx::ANGLE_QUARTER)
+      if (q > a0) add(q, R_);
+    return {x0 - 1, y0 - 1, x1 - x0 + 3, y1 - y0 + 3};
+  }
+
+  // Ring pixels with angle in [a0, a1), ring centre at (ox + R, oy + R) of spr.
+  void drawWedge_(TFT_eSprite& spr, int ox, int oy, int32_t a0, int32_t a1, uint16_t color) {
+    while (a0 < a1) {
+      const int32_t e = std::min(a1, a0 + fx::ANGLE_QUARTER);   // half-plane cuts need < 180°
+      drawSector_(spr, ox + R_, oy + R_, a0, e, color);
+      a0 = e;
+    }
+  }
+
+  // A pixel at (dx, dy) from the centre has angle in [a, a + 180°) exactly
+  // when dx cos a + dy sin a >= 0; each row is cut to that for a0 and to its
+  // complement for a1, then to the ring's spans from the tables.
+  void drawSector_(TFT_eSprite& spr, int cx, int cy, int32_t a0, int32_t a1, uint16_t color) {
+    const int32_t c0 = fx::cos_q15(a0), s0 = fx::sin_q15(a0);
+    const int32_t c1 = fx::cos_q15(a1), s1 = fx::sin_q15(a1);
+    for (int dy = -R_; dy <= R_; ++dy) {
+      const int d = dy < 0 ? -dy : dy;
+      int lo = -outer_[d], hi = outer_[d];
+      if (!cut_(c0, dy * s0, lo, hi) || !cut_(-c1, -dy * s1 - 1, lo, hi)) continue;
+      const int in = inner_[d];
+      if (in < 0) { spr.drawFastHLine(cx + lo, cy + dy, hi - lo + 1, color); continue; }
+      if (lo < -in) spr.drawFastHLine(cx + lo, cy + dy, std::min(hi, -in - 1) - lo + 1, color);
+      if (hi > in) {
+        const int l = std::max(lo, in + 1);
+        spr.drawFastHLine(cx + l, cy + dy, hi - l + 1, color);
+      }
+    }
+  }
+
+  // Narrows [lo, hi] to the x with x * a + k >= 0; false if none are left.
+  static bool cut_(int32_t a, int32_t k, int& lo, int& hi) {
+    if (a > 0) lo = std::max<int32_t>(lo, floorDiv_(-k + a - 1, a));
+    else if (a < 0) hi = std::min<int32_t>(hi, floorDiv_(k, -a));
+    else if (k < 0) return false;
+    return lo <= hi;
+  }
+  static int32_t floorDiv_(int32_t n, int32_t d) { return n >= 0 ? n / d : -((-n + d - 1) / d); }
+
+  void updateWidest_() {
+    snprintf(widest_, sizeof(widest_), "%s%.*f", lo_ < 0 ? "-" : "", decimals_,
+             std::max(std::fabs(lo_), std::fabs(hi_)));
+    for (char* p = widest_; *p; ++p) if (*p >= '1' && *p <= '9') *p = '0';
+  }
+
+  void updateText_() {
+    char buf[16];
+    if (std::isnan(v_)) snprintf(buf, sizeof(buf), "--");
+    else snprintf(buf, sizeof(buf), "%.*f", decimals_, v_);
+    Rect changed;
+    if (value_.Set(buf, changed)) AddDamage(changed); else Invalidate();
+  }
+
+  bool ensureArc_(TFT_eSPI& tft, TFT_eSprite& spr) {
+    const int w = 2 * R_ + 1, h = R_ + R_ * 71 / 100 + 2;
+    const int depth = spr.getColorDepth();
+    if (arc_ && arc_->width() == w && arc_->height() == h && arc_->getColorDepth() == depth)
+      return true;
+    freeArc_();
+    arc_ = new TFT_eSprite(&tft);
+    arc_->setAttribute(PSRAM_ENABLE, 1);
+    arc_->setColorDepth(depth);
+    if (!arc_->createSprite(w, h)) { freeArc_(); return false; }
+    arc_->fillSprite(bg);
+    redraw_ = true;
+    return true;
+  }
+
+  void freeArc_() {
+    if (!arc_) return;
+    arc_->deleteSprite();
+    delete arc_;
+    arc_ = nullptr;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,237 @@
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include <TFT_eSPI.h>
+
+#include "PanelItem.h"
+
+#ifndef glyphAtlas_h
+#define glyphAtlas_h
+
+namespace touch_panel {
+
+// ---------- GlyphAtlas: pre-rendered numeric glyphs for one font/colour/depth ----------
+// Digits and the few symbols numeric readouts use are drawn once into a PSRAM
+// sprite; text made only of those is then copied row by row instead of going
+// through drawString(). The font's own glyphs are used, plus a drawn '°'
+// (U+00B0), which the built-in GLCD/RLE fonts do not have.
+class GlyphAtlas {
+public:
+  static constexpr const char* CHARSET = " 0123456789:.,%-+C";
+  static constexpr uint16_t DEGREE = 0xB0;
+
+  // Shared atlas for this font/colours/depth, built on first request.
+  static GlyphAtlas* get(TFT_eSPI& tft, int font, uint16_t fg, uint16_t bg, int depth) {
+    static std::vector<GlyphAtlas*> atlases;
+    for (auto* a : atlases)
+      if (a->font_ == font && a->fg_ == fg && a->bg_ == bg && a->depth_ == depth) return a;
+    auto* a = new GlyphAtlas(font, fg, bg, depth);
+    if (!a->build_(tft)) { delete a; return nullptr; }
+    atlases.push_back(a);
+    return a;
+  }
+
+  int height() const { return h_; }
+  int depth() const { return depth_; }
+
+  // Glyph index of the next character in s (UTF-8), advancing s; -1 if not in the atlas.
+  int next(const char*& s) const {
+    uint16_t c = (uint8_t) *s++;
+    if (c == 0xC2 && (uint8_t) *s == DEGREE) { ++s; c = DEGREE; }
+    if (c == DEGREE) return degree_;
+    return c < 128 ? index_[c] : -1;
+  }
+
+  int width(int glyph) const { return glyphs_[glyph].w; }
+
+  // Width of s in pixels, or -1 if any character is missing.
+  int text_width(const char* s) const {
+    int w = 0;
+    while (*s) {
+      int g = next(s);
+      if (g < 0) return -1;
+      w += glyphs_[g].w;
+    }
+    return w;
+  }
+
+  // Copies one glyph to (x,y) in dst (same colour depth), clipped to dst.
+  void blit(TFT_eSprite& dst, int glyph, int x, int y) const {
+    blit_rect(dst, glyphs_[glyph].x, glyphs_[glyph].w, x, y);
+  }
+
+  // Fills a span of background of width w.
+  void fill_bg(TFT_eSprite& dst, int x, int y, int w) const {
+    if (w > 0) dst.fillRect(x, y, w, h_, bg_);
+  }
+
+private:
+  struct Glyph { int16_t x, w; };
+
+  int font_;
+  uint16_t fg_, bg_;
+  int depth_;
+  int h_{0};
+  TFT_eSprite* spr_{nullptr};
+  std::vector<Glyph> glyphs_;
+  int8_t index_[128];
+  int degree_{-1};
+
+  GlyphAtlas(int font, uint16_t fg, uint16_t bg, int depth)
+  : font_(font), fg_(fg), bg_(bg), depth_(depth) {
+    memset(index_, -1, sizeof(index_));
+  }
+
+  bool build_(TFT_eSPI& tft) {
+    h_ = tft.fontHeight(font_);
+    int total = 0;
+    char one[2] = {0, 0};
+    for (const char* c = CHARSET; *c; ++c) {
+      one[0] = *c;
+      const int w = tft.textWidth(one, font_);
+      if (w <= 0) continue;
+      index_[(uint8_t) *c] = (int8_t) glyphs_.size();
+      glyphs_.push_back({(int16_t) total, (int16_t) w});
+      total += w;
+    }
+    const int dw = std::max(4, h_ / 4 + 2);
+    degree_ = (int) glyphs_.size();
+    glyphs_.push_back({(int16_t) total, (int16_t) dw});
+    total += dw;
+
+    spr_ = new TFT_eSprite(&tft);
+    spr_->setAttribute(PSRAM_ENABLE, 1);
+    spr_->setColorDepth(depth_);
+    if (!spr_->createSprite(total, h_)) { delete spr_; spr_ = nullptr; return false; }
+    spr_->fillSprite(bg_);
+    spr_->setTextColor(fg_, bg_);
+    spr_->setTextDatum(TL_DATUM);
+    for (const char* c = CHARSET; *c; ++c) {
+      const int g = index_[(uint8_t) *c];
+      if (g >= 0) spr_->drawChar(*c, glyphs_[g].x, 0, font_);
+    }
+    const int r = std::max(1, h_ / 9);
+    spr_->drawCircle(glyphs_[degree_].x + dw / 2, r + 2, r, fg_);
+    return true;
+  }
+
+  void blit_rect(TFT_eSprite& dst, int sx, int w, int x, int y) const {
+    // Clip to the destination sprite.
+    int x0 = std::max(0, x), x1 = std::min<int>(dst.width(), x + w);
+    int y0 = std::max(0, y), y1 = std::min<int>(dst.height(), y + h_);
+    if (x0 >= x1 || y0 >= y1) return;
+    sx += x0 - x;
+    const int bpp = depth_ / 8;
+    const int sstride = spr_->width() * bpp, dstride = dst.width() * bpp;
+    const uint8_t* src = (const uint8_t*) spr_->getPointer() + (y0 - y) * sstride + sx * bpp;
+    uint8_t* out = (uint8_t*) dst.getPointer() + y0 * dstride + x0 * bpp;
+    for (int row = y0; row < y1; ++row, src += sstride, out += dstride)
+      memcpy(out, src, (x1 - x0) * bpp);
+  }
+};
+
+// ---------- TextField: one line of text at a fixed spot in an item ----------
+// Per-instance replacement for drawString() + setTextPadding(): the padding
+// width is measured once per field from a template string, and Set() reports
+// which part of the field changed so the item can damage only that.
+// Falls back to drawString() for text the atlas cannot draw, and for sprites
+// that are not 8 or 16 bit.
+class TextField {
+public:
+  TextField(int font, uint16_t fg, uint16_t bg, const char* widest, uint8_t datum = TL_DATUM)
+  : font_(font), fg_(fg), bg_(bg), widest_(widest), datum_(datum) {}
+
+  // Anchor point, interpreted per datum (TL_DATUM or TC_DATUM).
+  void SetPos(int x, int y) { x_ = x; y_ = y; }
+
+  // Build the atlas and measure the padding; call before the first Set().
+  void Prepare(TFT_eSPI& tft, int depth) {
+    if (atlas_ && atlas_->depth() == depth) return;
+    atlas_ = (depth == 8 || depth == 16) ? GlyphAtlas::get(tft, font_, fg_, bg_, depth) : nullptr;
+    pad_w_ = tft.textWidth(widest_, font_);
+    h_ = tft.fontHeight(font_);
+  }
+
+  // Returns false when the changed area is unknown (field not prepared or
+  // text not drawable from the atlas) and the whole item should repaint.
+  bool Set(const char* s, Rect& changed) {
+    changed = {0, 0, 0, 0};
+    if (text_ == s) return true;
+    std::string old = text_;
+    text_ = s;
+    if (!atlas_) return false;
+    int ox[MAX_CHARS + 1], nx[MAX_CHARS + 1], on, nn;
+    if (!layout_(old.c_str(), ox, on) || !layout_(text_.c_str(), nx, nn)) return false;
+
+    // First glyph that differs in content or position; everything after it changes.
+    const char* a = old.c_str();
+    const char* b = text_.c_str();
+    int k = 0;
+    while (k < on && k < nn && ox[k] == nx[k]) {
+      const int ga = atlas_->next(a), gb = atlas_->next(b);
+      if (ga != gb) break;
+      ++k;
+    }
+    const int x0 = std::min(k < on ? ox[k] : ox[on], k < nn ? nx[k] : nx[nn]);
+    const int x1 = std::max(ox[on], nx[nn]);
+    if (x1 > x0) changed = {x0, y_, x1 - x0, h_};
+    return true;
+  }
+
+  // Whole field including padding (item-local).
+  Rect Bounds() const {
+    const int w = std::max(pad_w_, atlas_ ? atlas_->text_width(text_.c_str()) : pad_w_);
+    return {datum_ == TC_DATUM ? x_ - w / 2 : x_, y_, w, h_};
+  }
+
+  void Draw(TFT_eSprite& spr) {
+    int xs[MAX_CHARS + 1], n;
+    if (!atlas_ || atlas_->depth() != spr.getColorDepth() || !layout_(text_.c_str(), xs, n)) {
+      spr.setTextDatum(datum_);
+      spr.setTextColor(fg_, bg_);
+      spr.setTextPadding(pad_w_);
+      spr.drawString(text_.c_str(), x_, y_, font_);
+      spr.setTextPadding(0);
+      return;
+    }
+    // Padding on either side, as drawString() would with setTextPadding().
+    const Rect box = Bounds();
+    atlas_->fill_bg(spr, box.x, y_, xs[0] - box.x);
+    atlas_->fill_bg(spr, xs[n], y_, box.x + box.w - xs[n]);
+    const char* s = text_.c_str();
+    for (int i = 0; i < n; ++i) atlas_->blit(spr, atlas_->next(s), xs[i], y_);
+  }
+
+private:
+  static constexpr int MAX_CHARS = 24;
+
+  int font_;
+  uint16_t fg_, bg_;
+  const char* widest_;
+  uint8_t datum_;
+  int x_{0}, y_{0};
+  int pad_w_{0}, h_{0};
+  GlyphAtlas* atlas_{nullptr};
+  std::string text_;
+
+  // x of each glyph of s plus the end position; false if not drawable.
+  bool layout_(const char* s, int* xs, int& n) const {
+    const int w = atlas_->text_width(s);
+    if (w < 0) return false;
+    int x = datum_ == TC_DATUM ? x_ - w / 2 : x_;
+    n = 0;
+    while (*s && n < MAX_CHARS) {
+      xs[n++] = x;
+      x += atlas_->width(atlas_->next(s));
+    }
+    xs[n] = x;
+    return *s == 0;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
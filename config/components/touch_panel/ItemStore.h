@@ -0,0 +1,102 @@
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "PanelItem.h"
+
+#ifndef itemStore_h
+#define itemStore_h
+
+namespace touch_panel {
+
+// ---------- ItemStore: flat, page-partitioned item storage ----------
+// Items live in one vector ordered by page (insertion order, i.e. z-order, is
+// kept within a page) with their cell bounds inline. page_start_ holds the
+// offset of each page, so per-frame work only touches the visible page.
+// Ids are indexed by hash; lookups verify the string on a hash hit.
+class ItemStore {
+public:
+  struct Slot {
+    IPanelItem* item;
+    Rect bounds;
+    bool owned;   // deleted by clear(); false for statically allocated items
+  };
+
+  // Contiguous slots of one page.
+  struct Span {
+    Slot* b;
+    Slot* e;
+    Slot* begin() const { return b; }
+    Slot* end() const { return e; }
+    bool empty() const { return b == e; }
+  };
+
+  ~ItemStore() { clear(); }
+
+  // Takes ownership of item unless owned is false.
+  void add(IPanelItem* item, const Rect& bounds, int page, bool owned = true) {
+    if (page < 0) page = 0;
+    if ((size_t) page + 2 > page_start_.size()) page_start_.resize(page + 2, slots_.size());
+    // Append at the end of the item's page, shifting later pages up by one.
+    const uint32_t at = page_start_[page + 1];
+    slots_.insert(slots_.begin() + at, Slot{item, bounds, owned});
+    for (size_t p = page + 1; p < page_start_.size(); ++p) ++page_start_[p];
+    by_id_.emplace(hash_(item->Id()), item);
+  }
+
+  void clear() {
+    for (auto& s : slots_) if (s.owned) delete s.item;
+    slots_.clear();
+    page_start_.assign(1, 0);
+    by_id_.clear();
+  }
+
+  bool empty() const { return slots_.empty(); }
+  size_t size() const { return slots_.size(); }
+
+  // Number of pages including empty ones below the highest used page (>= 1).
+  int page_count() const { return std::max<int>(1, (int) page_start_.size() - 1); }
+
+  Span page(int p) {
+    if (p < 0 || p + 1 >= (int) page_start_.size()) return {nullptr, nullptr};
+    Slot* base = slots_.data();
+    return {base + page_start_[p], base + page_start_[p + 1]};
+  }
+
+  Span all() {
+    Slot* base = slots_.data();
+    return {base, base + slots_.size()};
+  }
+
+  // Calls fn for every item with this id (ids are not required to be unique).
+  template <typename Fn>
+  void for_id(const char* id, Fn fn) {
+    auto range = by_id_.equal_range(hash_(id));
+    for (auto it = range.first; it != range.second; ++it)
+      if (strcmp(it->second->Id(), id) == 0) fn(it->second);
+  }
+
+  IPanelItem* find(const char* id) {
+    IPanelItem* found = nullptr;
+    for_id(id, [&](IPanelItem* it){ if (!found) found = it; });
+    return found;
+  }
+
+private:
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> page_start_{0};
+  std::unordered_multimap<uint32_t, IPanelItem*> by_id_;
+
+  // FNV-1a
+  static uint32_t hash_(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) { h ^= (uint8_t) *s++; h *= 16777619u; }
+    return h;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -4,10 +4,10 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 
-#include "esphome.h"
 #include <TFT_eSPI.h>
-#include <XPT2046_Touchscreen.h>
 
 #include "PanelItem.h"
 
@@ -17,31 +17,33 @@
 namespace touch_panel {
 
 // ---------- LightItem: centered text + subtle 3D ----------
-class LightItem : public BaseItem {
+class LightItem : public ToggleItem {
 public:
   LightItem(const char* id, const char* label, int page=0)
-  : BaseItem(id, page), label_(label) {}
-
-  void SetState(bool on) { if (on_ != on) { on_ = on; Invalidate(); } }
-  bool State() const { return on_; }
-
- bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
-    uint16_t fill   = on_ ? TFT_YELLOW : TFT_NAVY;
-    uint16_t stroke = on_ ? TFT_WHITE : TFT_LIGHTGREY;
-    uint16_t text = on_ ? TFT_BLACK : TFT_LIGHTGREY;
+  : ToggleItem(id, page), label_(label) {
+    SetColorDepth(4);
+  }
 
-    spr.fillRoundRect(0, 0, B().w, B().h, 8, fill);
-    spr.drawRoundRect(0, 0, B().w, B().h, 8, stroke);
-    spr.setTextDatum(MC_DATUM);
-    spr.setTextColor(text, fill);
-    spr.drawString(label_.c_str(), B().w/2, B().h/2, 2);
+  int DrawList(DrawCmd* out, int max) const override {
+    if (max < 3) return 0;
+    const bool on = Shown();
+    const uint16_t fill   = on ? TFT_YELLOW : TFT_NAVY;
+    const uint16_t stroke = Pending() ? TFT_ORANGE : on ? TFT_WHITE : TFT_LIGHTGREY;
+    const uint16_t text   = on ? TFT_BLACK : TFT_LIGHTGREY;
+    const Rect r{0, 0, B().w, B().h};
+    out[0] = {DrawCmd::FILL_ROUND_RECT, r, fill, 0, 8};
+    out[1] = {DrawCmd::STROKE_ROUND_RECT, r, stroke, 0, 8};
+    out[2] = {DrawCmd::TEXT, r, text, fill, 0, 2, label_.c_str()};
+    return 3;
+  }
 
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    RenderDrawList(spr);
     return true;
   }
 
 private:
   std::string label_;
-  bool on_{false};
 };
 
 } // namespace touch_panel
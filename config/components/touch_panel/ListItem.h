@@ -0,0 +1,189 @@
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include <TFT_eSPI.h>
+
+#include "PanelItem.h"
+
+#ifndef listItem_h
+#define listItem_h
+
+namespace touch_panel {
+
+// ---------- ListItem: long lists scrolled by dragging ----------
+// Entries come from a source callback, so the item never holds them. Rows are
+// rendered into a ring of row slots (PSRAM) big enough for the window plus
+// OVERSCAN rows on either side; entry i lives in slot i % slots. A scroll step
+// renders only the entries that newly entered the ring and assembles the
+// window from it with row copies. Memory depends on the cell size only.
+class ListItem : public BaseItem {
+public:
+  using Source = std::function<const char*(int index)>;
+
+  static constexpr int ROW_H = 36;
+  static constexpr int OVERSCAN = 1;   // rows rendered ahead above and below the window
+
+  ListItem(const char* id="list", int page=0) : BaseItem(id, page) {
+    SetColorDepth(4);   // flat colours; smallest ring and push
+  }
+  ~ListItem() override { freeRing_(); }
+
+  // Call before the first frame or from the render step.
+  void SetSource(int count, Source src) {
+    count_ = std::max(0, count);
+    src_ = std::move(src);
+    selected_ = -1;
+    scroll_ = std::min(scroll_, maxScroll_());
+    dropRows_();
+    Invalidate();
+  }
+  // Entries in a static array (e.g. the `entries:` generated by __init__.py).
+  void SetEntries(const char* const* entries, int count) {
+    SetSource(count, [entries](int i){ return entries[i]; });
+  }
+
+  // Entry of the last click, -1 before the first; for on_click handlers.
+  int Selected() const { return selected_.load(std::memory_order_relaxed); }
+
+  void SetBounds(const Rect& r) override {
+    if (r.w != B().w || r.h != B().h) dropRows_();
+    BaseItem::SetBounds(r);
+    scroll_ = std::min(scroll_, maxScroll_());
+  }
+
+  // Vertical drags scroll; horizontal swipes still reach the panel.
+  bool OnTouch(const TouchEvent& e) override {
+    switch (e.type) {
+      case TouchType::MOVE:
+        scrollTo_(scroll_ - e.dy);
+        return true;
+      case TouchType::SWIPE_UP:
+      case TouchType::SWIPE_DOWN:
+        return true;
+      case TouchType::CLICK: {
+        const int i = (scroll_ + e.y - B().y) / ROW_H;
+        if (i >= 0 && i < count_) {
+          select_(i);
+          OnClick();
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+    const int h = B().h;
+    if (!ensureRing_(tft, spr)) {
+      // No memory for the ring: draw the visible rows straight into the cell.
+      for (int i = scroll_ / ROW_H; i < count_ && i * ROW_H < scroll_ + h; ++i)
+        drawRow_(spr, i, i * ROW_H - scroll_);
+      drawScrollbar_(spr);
+      return true;
+    }
+
+    const int n = (int) slots_.size();
+    const int first = std::max(0, scroll_ / ROW_H - OVERSCAN);
+    const int last = std::min(count_ - 1, (scroll_ + h - 1) / ROW_H + OVERSCAN);
+    for (int i = first; i <= last; ++i) {
+      int& slot = slots_[i % n];
+      if (slot == i) continue;
+      drawRow_(*ring_, i, (i % n) * ROW_H);
+      slot = i;
+    }
+
+    // Window rows from the ring; past the last entry the cell stays clear.
+    const int depth = spr.getColorDepth();
+    const size_t row_bytes = depth == 4 ? (B().w + 1) / 2 : (size_t) B().w * depth / 8;
+    const size_t rs = (size_t) ring_->width() * depth / 8, ds = (size_t) spr.width() * depth / 8;
+    const uint8_t* src = (const uint8_t*) ring_->getPointer();
+    uint8_t* dst = (uint8_t*) spr.getPointer();
+    for (int y = 0; y < h; ++y) {
+      const int cy = scroll_ + y;
+      const int i = cy / ROW_H;
+      if (i >= count_) break;
+      memcpy(dst + y * ds, src + ((i % n) * ROW_H + cy % ROW_H) * rs, row_bytes);
+    }
+    drawScrollbar_(spr);
+    return true;
+  }
+
+private:
+  Source src_;
+  int count_{0};
+  int scroll_{0};                      // px from the top of the first entry
+  std::atomic<int> selected_{-1};
+  TFT_eSprite* ring_{nullptr};
+  std::vector<int> slots_;             // entry held by each ring slot, -1 = none
+
+  int maxScroll_() const { return std::max(0, count_ * ROW_H - B().h); }
+
+  void scrollTo_(int s) {
+    s = std::max(0, std::min(s, maxScroll_()));
+    if (s == scroll_) return;
+    scroll_ = s;
+    Invalidate();
+  }
+
+  void select_(int i) {
+    const int old = selected_.exchange(i, std::memory_order_relaxed);
+    if (old == i) return;
+    // Both rows change colour; re-render them from the source.
+    for (int& slot : slots_) if (slot == old || slot == i) slot = -1;
+    Invalidate();
+  }
+
+  void dropRows_() { std::fill(slots_.begin(), slots_.end(), -1); }
+
+  void drawRow_(TFT_eSprite& spr, int i, int y) {
+    const int w = B().w;
+    const bool sel = i == selected_.load(std::memory_order_relaxed);
+    const uint16_t bg = Ink(sel ? TFT_NAVY : TFT_BLACK);
+    spr.fillRect(0, y, w, ROW_H, bg);   // a ring slot still holds its previous entry
+    spr.drawFastHLine(6, y + ROW_H - 1, w - 12, Ink(TFT_DARKGREY));
+    spr.setTextDatum(ML_DATUM);
+    spr.setTextColor(Ink(sel ? TFT_WHITE : TFT_LIGHTGREY), bg);
+    const char* s = src_ ? src_(i) : nullptr;
+    if (s) spr.drawString(s, 8, y + ROW_H / 2, 4);
+  }
+
+  void drawScrollbar_(TFT_eSprite& spr) {
+    const int h = B().h, content = count_ * ROW_H;
+    if (content <= h) return;
+    const int th = std::max(12, h * h / content);
+    const int ty = (int)((int64_t) scroll_ * (h - th) / (content - h));
+    spr.fillRect(B().w - 3, ty, 2, th, Ink(TFT_DARKGREY));
+  }
+
+  bool ensureRing_(TFT_eSPI& tft, TFT_eSprite& spr) {
+    const int depth = spr.getColorDepth();
+    const int w = depth == 4 ? (B().w + 1) & ~1 : B().w;   // whole bytes per 4-bit row
+    const int n = (B().h + ROW_H - 1) / ROW_H + 1 + 2 * OVERSCAN;
+    if (ring_ && ring_->width() == w && (int) slots_.size() == n && ring_->getColorDepth() == depth)
+      return true;
+    freeRing_();
+    ring_ = new TFT_eSprite(&tft);
+    ring_->setAttribute(PSRAM_ENABLE, 1);
+    ring_->setColorDepth(depth);
+    if (!ring_->createSprite(w, n * ROW_H)) { freeRing_(); return false; }
+    slots_.assign(n, -1);
+    return true;
+  }
+
+  void freeRing_() {
+    slots_.clear();
+    if (!ring_) return;
+    ring_->deleteSprite();
+    delete ring_;
+    ring_ = nullptr;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,103 @@
+#include <vector>
+#include <cstdint>
+
+#include <TFT_eSPI.h>
+
+#ifndef pageCache_h
+#define pageCache_h
+
+namespace touch_panel {
+
+// ---------- PageCache: composed frame per page in PSRAM ----------
+// Each cached page keeps a screen-sized 16-bit sprite that mirrors what the
+// panel last pushed for it, so showing the page again is one streaming push
+// instead of re-rendering every item. Frames are created on demand and, once
+// the memory limit is reached, the least recently shown page is evicted.
+class PageCache {
+public:
+  explicit PageCache(TFT_eSPI& tft) : tft_(tft) {}
+  ~PageCache() { clear(); }
+
+  // 0 disables the cache.
+  void set_limit(uint32_t bytes) { limit_ = bytes; trim_(-1); }
+  bool enabled() const { return limit_ >= frame_bytes_() && w_ > 0; }
+
+  void set_size(int w, int h) {
+    if (w == w_ && h == h_) return;
+    clear();
+    w_ = w; h_ = h;
+  }
+  int width() const { return w_; }
+  int height() const { return h_; }
+
+  // Frame of page p, or nullptr if it is not cached.
+  TFT_eSprite* find(int p) const {
+    for (auto& e : entries_) if (e.page == p) return e.spr;
+    return nullptr;
+  }
+
+  // Marks p as just shown (for eviction).
+  void touch(int p) {
+    for (auto& e : entries_) if (e.page == p) e.used = ++clock_;
+  }
+
+  // New black frame for p, evicting other pages as needed; nullptr if it
+  // does not fit or PSRAM is exhausted.
+  TFT_eSprite* create(int p) {
+    drop(p);
+    if (!enabled()) return nullptr;
+    trim_(p, frame_bytes_());
+    auto* spr = new TFT_eSprite(&tft_);
+    spr->setAttribute(PSRAM_ENABLE, 1);
+    spr->setColorDepth(16);
+    if (!spr->createSprite(w_, h_)) {
+      delete spr;
+      return nullptr;
+    }
+    spr->fillSprite(TFT_BLACK);
+    entries_.push_back({p, spr, ++clock_});
+    return spr;
+  }
+
+  void drop(int p) {
+    for (size_t i = 0; i < entries_.size(); ++i)
+      if (entries_[i].page == p) { free_(i); return; }
+  }
+
+  void clear() { while (!entries_.empty()) free_(entries_.size() - 1); }
+
+  uint32_t bytes() const { return entries_.size() * frame_bytes_(); }
+
+private:
+  struct Entry { int page; TFT_eSprite* spr; uint32_t used; };
+
+  TFT_eSPI& tft_;
+  uint32_t limit_{0};
+  int w_{0}, h_{0};
+  std::vector<Entry> entries_;
+  uint32_t clock_{0};
+
+  uint32_t frame_bytes_() const { return (uint32_t) w_ * h_ * 2; }
+
+  // Evicts least recently shown pages (never `keep`) until `extra` more bytes fit.
+  void trim_(int keep, uint32_t extra = 0) {
+    while (!entries_.empty() && bytes() + extra > limit_) {
+      size_t lru = entries_.size();
+      for (size_t i = 0; i < entries_.size(); ++i)
+        if (entries_[i].page != keep && (lru == entries_.size() || entries_[i].used < entries_[lru].used))
+          lru = i;
+      if (lru == entries_.size()) return;
+      free_(lru);
+    }
+  }
+
+  void free_(size_t i) {
+    entries_[i].spr->deleteSprite();
+    delete entries_[i].spr;
+    entries_.erase(entries_.begin() + i);
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -4,10 +4,10 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
 
-#include "esphome.h"
 #include <TFT_eSPI.h>
-#include <XPT2046_Touchscreen.h>
 
 #ifndef panelitem_h
 #define panelitem_h
@@ -17,6 +17,79 @@ namespace touch_panel {
     // ---------- Geometry helpers ----------
     struct Rect { int x,y,w,h; };
     static inline bool hit(const Rect&r,int x,int y){return x>=r.x && x<r.x+r.w && y>=r.y && y<r.y+r.h;}
+    static inline bool empty(const Rect&r){return r.w<=0 || r.h<=0;}
+    static inline Rect intersect(const Rect&a,const Rect&b){
+      const int x0=std::max(a.x,b.x), y0=std::max(a.y,b.y);
+      const int x1=std::min(a.x+a.w,b.x+b.w), y1=std::min(a.y+a.h,b.y+b.h);
+      return {x0,y0,std::max(0,x1-x0),std::max(0,y1-y0)};
+    }
+    static inline Rect unite(const Rect&a,const Rect&b){
+      if (empty(a)) return b;
+      if (empty(b)) return a;
+      const int x0=std::min(a.x,b.x), y0=std::min(a.y,b.y);
+      const int x1=std::max(a.x+a.w,b.x+b.w), y1=std::max(a.y+a.h,b.y+b.h);
+      return {x0,y0,x1-x0,y1-y0};
+    }
+
+    // ---------- Touch events (see TouchEngine.h) ----------
+    enum class TouchType : uint8_t { PRESS, MOVE, LONG_PRESS, CLICK, SWIPE_LEFT, SWIPE_RIGHT, SWIPE_UP, SWIPE_DOWN, RELEASE };
+    struct TouchEvent {
+      TouchType type;
+      int16_t x, y;     // screen coordinates (filtered)
+      int16_t dx, dy;   // MOVE: delta since last MOVE; swipes: total travel
+      uint32_t t_ms;
+    };
+
+    // Max sub-rectangles an item can report per frame before they collapse into one.
+    static constexpr int MAX_DAMAGE_RECTS = 8;
+
+    // ---------- Draw lists (see DrawList.h) ----------
+    // Flat items can describe themselves as primitives, in paint order. The
+    // panel then sends large solid areas as controller fills and pushes only
+    // the rest of the cell from the sprite. Colours are RGB565.
+    struct DrawCmd {
+      enum Kind : uint8_t { FILL_RECT, FILL_ROUND_RECT, STROKE_ROUND_RECT, TEXT };
+      Kind kind;
+      Rect r;                  // item-local; TEXT is centred in r
+      uint16_t color;          // TEXT: foreground
+      uint16_t bg{0};          // TEXT: background
+      uint8_t radius{0};       // round rects
+      uint8_t font{0};         // TEXT
+      const char* text{nullptr};
+    };
+    static constexpr int MAX_DRAW_CMDS = 8;
+
+    // ---------- Broadcast topics (see EventBus.h) ----------
+    enum Topic : uint8_t { TOPIC_TIME, TOPIC_ENV, TOPIC_COUNT };
+    using TopicMask = uint8_t;
+    constexpr TopicMask topic_bit(Topic t) { return TopicMask(1u << t); }
+
+    // ---------- Pixel formats ----------
+    // Items render into a sprite of their own colour depth:
+    //   4  indexed, 16-colour palette per item (flat UI; smallest, cheapest to expand)
+    //   8  RGB332 (default)
+    //   16 RGB565, native (gradients, colours that must not be quantized)
+    static constexpr int PALETTE_SIZE = 16;
+    // Default 4-bit palette: the stock TFT_eSPI colours the built-in items use.
+    // Index 0 is the background the panel clears to and must stay black.
+    static constexpr uint16_t DEFAULT_PALETTE[PALETTE_SIZE] = {
+      TFT_BLACK, TFT_WHITE, TFT_LIGHTGREY, TFT_DARKGREY, TFT_SILVER, TFT_RED, TFT_GREEN, TFT_BLUE,
+      TFT_YELLOW, TFT_NAVY, TFT_ORANGE, TFT_CYAN, TFT_MAGENTA, TFT_DARKGREEN, TFT_MAROON, TFT_PURPLE };
+
+    // Index of the palette entry closest to RGB565 colour c.
+    inline int palette_index(const uint16_t* pal, uint16_t c) {
+      int best = 0, best_d = 1 << 30;
+      for (int i=0;i<PALETTE_SIZE;++i) {
+        const uint16_t p = pal[i];
+        if (p == c) return i;
+        const int dr = (p >> 11) - (c >> 11);
+        const int dg = ((p >> 5) & 0x3F) - ((c >> 5) & 0x3F);
+        const int db = (p & 0x1F) - (c & 0x1F);
+        const int d = 4*dr*dr + dg*dg + 4*db*db;
+        if (d < best_d) { best_d = d; best = i; }
+      }
+      return best;
+    }
 
     // ---------- Panel Item Interface + Base ----------
     class IPanelItem {
@@ -32,40 +105,268 @@ namespace touch_panel {
     virtual bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) = 0;
 
     virtual void Tick(uint32_t now_ms) {}
+    // Called once before the first frame with the panel's sprite, for
+    // one-time setup that needs the display (glyph atlases, text metrics).
+    virtual void Prepare(TFT_eSPI& tft, TFT_eSprite& spr) {}
     virtual bool HitTest(int x, int y) const = 0;
 
+    // Colour depth of the sprite this item renders into (4, 8 or 16).
+    virtual uint8_t ColorDepth() const { return 8; }
+    virtual void SetColorDepth(uint8_t /*depth*/) {}
+    // PALETTE_SIZE RGB565 entries for 4-bit items, nullptr otherwise.
+    virtual const uint16_t* Palette() const { return nullptr; }
+    // Compositor: false leaves the item's black pixels (the colour its sprite
+    // is cleared to) out, so items below show through; true copies the whole cell.
+    virtual bool Opaque() const { return false; }
+    virtual void SetOpaque(bool /*on*/) {}
+
     virtual bool ClearDirty() = 0;
+    // The item as draw commands (full repaint); 0 if it does not have one.
+    virtual int DrawList(DrawCmd* /*out*/, int /*max*/) const { return 0; }
+    // Damaged regions in item-local coordinates since the last call.
+    // Returns 0 when the whole cell must be repainted.
+    virtual int TakeDamage(Rect* /*out*/, int /*max*/) { return 0; }
     virtual void OnClick() = 0;
     virtual void SetOnClick(std::function<void()>) = 0;
+    // Events of a touch that started on this item. Return true if consumed;
+    // unconsumed swipes fall through to the panel (page switching).
+    virtual bool OnTouch(const TouchEvent& e) { return false; }
+    // Panel broadcasts this item consumes; OnEnvUpdate/OnTimeUpdate are only
+    // called from the panel for the topics listed here.
+    virtual TopicMask Topics() const { return 0; }
     virtual void OnEnvUpdate(float /*t*/, float /*h*/) {}
+    // On/off state of the entity an item mirrors; ignored by items without one.
+    virtual void SetState(bool /*on*/) {}
     virtual void OnTimeUpdate(int /*hours*/, int /*minutes*/, int /*seconds*/) {}
+    // Optimistic feedback (ToggleItem): PENDING from a click until the entity
+    // answers (CONFIRMED) or the timeout passes (ROLLED_BACK).
+    enum class Feedback : uint8_t { NONE, PENDING, CONFIRMED, ROLLED_BACK };
+    virtual Feedback FeedbackState() const { return Feedback::NONE; }
     };
 
     class BaseItem : public IPanelItem {
     public:
-    explicit BaseItem(const char* id, int page=0) : id_(id), page_(page) {}
+    explicit BaseItem(const char* id, int page=0) : id_(id), page_(page) {
+      std::copy(DEFAULT_PALETTE, DEFAULT_PALETTE + PALETTE_SIZE, palette_);
+    }
 
-    void SetBounds(const Rect& r) override { bounds_ = r; dirty_ = true; }
-    void SetPage(int page) override { page_ = page; dirty_ = true; }
+    void SetBounds(const Rect& r) override { bounds_ = r; Invalidate(); }
+    void SetPage(int page) override { page_ = page; Invalidate(); }
     int  Page() const override { return page_; }
     const char* Id() const override { return id_.c_str(); }
 
+    int TakeDamage(Rect* out, int max) override {
+      int n = full_ ? 0 : std::min(damage_n_, max);
+      for (int i=0;i<n;++i) out[i] = damage_[i];
+      damage_n_ = 0;
+      full_ = false;
+      return n;
+    }
+
     bool HitTest(int x, int y) const override { return hit(bounds_, x, y); }
 
+    uint8_t ColorDepth() const override { return depth_; }
+    void SetColorDepth(uint8_t depth) override {
+      depth_ = (depth == 4 || depth == 16) ? depth : 8;
+      Invalidate();
+    }
+    const uint16_t* Palette() const override { return depth_ == 4 ? palette_ : nullptr; }
+    bool Opaque() const override { return opaque_; }
+    void SetOpaque(bool on) override { opaque_ = on; Invalidate(); }
+    // Replaces the 4-bit palette with up to PALETTE_SIZE-1 colours from index 1; index 0 stays black.
+    void SetPalette(const uint16_t* colors, int n) {
+      n = std::min(n, PALETTE_SIZE - 1);
+      for (int i=0;i<n;++i) palette_[i+1] = colors[i];
+      for (int i=n+1;i<PALETTE_SIZE;++i) palette_[i] = TFT_BLACK;
+      Invalidate();
+    }
+
     void SetOnClick(std::function<void()> fn) { on_click_ = std::move(fn); }
     void OnClick() override { if (on_click_) on_click_(); }
+    bool OnTouch(const TouchEvent& e) override {
+      if (e.type != TouchType::CLICK) return false;
+      OnClick();
+      return true;
+    }
 
     protected:
-    void Invalidate() { dirty_ = true; }
+    void Invalidate() { dirty_ = true; full_ = true; damage_n_ = 0; }
+    // Mark only part of the cell (local coords) for repaint.
+    void AddDamage(const Rect& r) {
+      if (dirty_ && full_) return;
+      Rect c = intersect(r, {0,0,bounds_.w,bounds_.h});
+      if (empty(c)) return;
+      dirty_ = true;
+      if (damage_n_ == MAX_DAMAGE_RECTS) {
+        for (int i=1;i<damage_n_;++i) c = unite(c, damage_[i]);
+        damage_[0] = unite(c, damage_[0]);
+        damage_n_ = 1;
+        return;
+      }
+      damage_[damage_n_++] = c;
+    }
     bool IsDirty() const { return dirty_; }
     bool ClearDirty() { bool d = dirty_; dirty_ = false; return d; }
     const Rect& B() const { return bounds_; }
 
+    // Draws DrawList() into spr, for items whose RenderIfDirty() is their draw list.
+    void RenderDrawList(TFT_eSprite& spr) const {
+      DrawCmd cmds[MAX_DRAW_CMDS];
+      const int n = DrawList(cmds, MAX_DRAW_CMDS);
+      for (int i=0;i<n;++i) {
+        const DrawCmd& c = cmds[i];
+        const Rect& r = c.r;
+        switch (c.kind) {
+          case DrawCmd::FILL_RECT:         spr.fillRect(r.x, r.y, r.w, r.h, Ink(c.color)); break;
+          case DrawCmd::FILL_ROUND_RECT:   spr.fillRoundRect(r.x, r.y, r.w, r.h, c.radius, Ink(c.color)); break;
+          case DrawCmd::STROKE_ROUND_RECT: spr.drawRoundRect(r.x, r.y, r.w, r.h, c.radius, Ink(c.color)); break;
+          case DrawCmd::TEXT:
+            spr.setTextDatum(MC_DATUM);
+            spr.setTextColor(Ink(c.color), Ink(c.bg));
+            spr.drawString(c.text, r.x + r.w/2, r.y + r.h/2, c.font);
+            break;
+        }
+      }
+    }
+
+    // Colour value to draw with: c itself, or for 4-bit items the index of
+    // the closest palette entry.
+    uint16_t Ink(uint16_t c) const {
+      return depth_ == 4 ? palette_index(palette_, c) : c;
+    }
+
     std::string id_;
     Rect bounds_{};
     int page_{0};
     bool dirty_{true};
+    bool full_{true};
+    Rect damage_[MAX_DAMAGE_RECTS]{};
+    int damage_n_{0};
     std::function<void()> on_click_{};
+    uint8_t depth_{8};
+    bool opaque_{false};
+    uint16_t palette_[PALETTE_SIZE];
+    };
+
+    // ---------- Toggle item: mirrors an on/off entity (switch, light) ----------
+    // Optimistic (SetOptimistic(), set by the panel for bound items): a click
+    // shows the flipped state at once, drawn as pending, and the entity's next
+    // change settles it; without one the item rolls back after the timeout.
+    // Repeats of the state the entity already had are not an answer.
+    class ToggleItem : public BaseItem {
+    public:
+    using BaseItem::BaseItem;
+
+    void SetState(bool on) override {
+      if (on_ == on) return;
+      on_ = on;
+      // Pending implies target_ != on_, so any change is the one clicked for.
+      if (feedback_ == Feedback::PENDING) feedback_ = Feedback::CONFIRMED;
+      Invalidate();
+    }
+    bool State() const { return on_; }
+
+    // 0 turns optimistic feedback off.
+    void SetOptimistic(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+    Feedback FeedbackState() const override { return feedback_; }
+
+    bool OnTouch(const TouchEvent& e) override {
+      if (e.type == TouchType::CLICK && timeout_ms_) {
+        target_ = !Shown();
+        // Clicked back before the entity answered: nothing left to wait for.
+        feedback_ = target_ == on_ ? Feedback::NONE : Feedback::PENDING;
+        since_ms_ = e.t_ms;
+        Invalidate();
+      }
+      return BaseItem::OnTouch(e);
+    }
+
+    void Tick(uint32_t now_ms) override {
+      if (feedback_ != Feedback::PENDING || now_ms - since_ms_ < timeout_ms_) return;
+      feedback_ = Feedback::ROLLED_BACK;
+      Invalidate();
+    }
+
+    protected:
+    bool on_{false};
+
+    // What to draw: the clicked state while pending, else the entity's.
+    bool Shown() const { return Pending() ? target_ : on_; }
+    bool Pending() const { return feedback_ == Feedback::PENDING; }
+
+    private:
+    uint32_t timeout_ms_{0};
+    Feedback feedback_{Feedback::NONE};
+    bool target_{false};
+    uint32_t since_ms_{0};
+    };
+
+    // ---------- Layered item: cached static layer + per-update dynamic layer ----------
+    // The static layer is rendered once into a PSRAM sprite and only rebuilt when the
+    // cell size or page changes (or on InvalidateStatic()). Each update copies it into
+    // the panel sprite and draws the dynamic layer on top.
+    class LayeredItem : public BaseItem {
+    public:
+    using BaseItem::BaseItem;
+    ~LayeredItem() override { freeCache_(); }
+
+    void SetBounds(const Rect& r) override {
+      if (r.w != bounds_.w || r.h != bounds_.h) static_dirty_ = true;
+      BaseItem::SetBounds(r);
+    }
+    void SetPage(int page) override { static_dirty_ = true; BaseItem::SetPage(page); }
+
+    bool RenderIfDirty(TFT_eSPI& tft, TFT_eSprite& spr) override {
+      if (!ensureCache_(tft, spr)) {
+        // No memory for the cache: draw both layers directly.
+        RenderStatic(spr);
+        RenderDynamic(spr);
+        return true;
+      }
+      if (static_dirty_) {
+        cache_->fillSprite(TFT_BLACK);
+        RenderStatic(*cache_);
+        static_dirty_ = false;
+      }
+      cache_->pushToSprite(&spr, 0, 0);
+      RenderDynamic(spr);
+      return true;
+    }
+
+    protected:
+    // Everything that only depends on the cell size (outlines, scales, tick marks).
+    virtual void RenderStatic(TFT_eSprite& spr) = 0;
+    // Everything that changes with the item's value; drawn over the static layer.
+    virtual void RenderDynamic(TFT_eSprite& spr) = 0;
+
+    void InvalidateStatic() { static_dirty_ = true; Invalidate(); }
+
+    private:
+    TFT_eSprite* cache_{nullptr};
+    bool static_dirty_{true};
+
+    bool ensureCache_(TFT_eSPI& tft, TFT_eSprite& spr) {
+      const int w = B().w, h = B().h;
+      const int depth = spr.getColorDepth();
+      // pushToSprite() does not carry a palette across; 4-bit items draw both layers.
+      if (depth == 4) return false;
+      if (cache_ && cache_->width() == w && cache_->height() == h && cache_->getColorDepth() == depth)
+        return true;
+      freeCache_();
+      cache_ = new TFT_eSprite(&tft);
+      cache_->setAttribute(PSRAM_ENABLE, 1);
+      cache_->setColorDepth(depth);
+      if (!cache_->createSprite(w, h)) { freeCache_(); return false; }
+      static_dirty_ = true;
+      return true;
+    }
+
+    void freeCache_() {
+      if (!cache_) return;
+      cache_->deleteSprite();
+      delete cache_;
+      cache_ = nullptr;
+    }
     };
 
 }
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <cstdint>
+
+#include "esphome.h"
+
+#ifndef perfStats_h
+#define perfStats_h
+
+namespace touch_panel {
+
+// Diagnostic values the panel can publish (see `diagnostics:` in __init__.py).
+enum PerfMetric : uint8_t {
+  PERF_LOOP_P50,        // render step duration percentiles, us
+  PERF_LOOP_P95,
+  PERF_LOOP_MAX,
+  PERF_RENDER_TIME,     // mean RenderIfDirty() per item, us
+  PERF_PIXELS,          // pixels pushed per second
+  PERF_BYTES,           // bytes on the SPI wire per second
+  PERF_DMA_WAIT,        // time blocked on DMA per second, us
+  PERF_TOUCH_LATENCY,   // touch read -> click handler, last click, us
+  PERF_FEEDBACK_LATENCY,// touch read -> pending state pushed, last optimistic click, us
+  PERF_CONFIRM_LATENCY, // touch read -> entity confirmed it, last optimistic click, us
+  PERF_ROLLBACKS,       // optimistic clicks the entity never confirmed, per window
+  PERF_FPS,             // frames that pushed pixels, per second
+  PERF_DROPPED,         // frame slots the pacer skipped (step overran), per second
+  PERF_SCRATCH_BYTES,   // scratch sprite size
+  PERF_SPI_BUSY,        // share of time the bus was held, %
+  PERF_SPI_TXNS,        // bus transactions (CS assertions) per second
+  PERF_COUNT
+};
+
+#ifdef TOUCH_PANEL_PERF
+
+// ---------- PerfStats: lock-free counters over a publish window ----------
+// Written from the render step (possibly on the render task), read and reset
+// from the ESPHome loop when publishing. Relaxed atomics only.
+class PerfStats {
+public:
+  uint32_t now() const { return micros(); }
+
+  void add_loop(uint32_t us) {
+    hist_[bucket_(us)].fetch_add(1, std::memory_order_relaxed);
+    uint32_t m = loop_max_.load(std::memory_order_relaxed);
+    while (us > m && !loop_max_.compare_exchange_weak(m, us, std::memory_order_relaxed)) {}
+  }
+  void add_render(uint32_t us) {
+    render_us_.fetch_add(us, std::memory_order_relaxed);
+    renders_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void add_frame(uint32_t px) {
+    px_.fetch_add(px, std::memory_order_relaxed);
+    frames_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void add_dma_wait(uint32_t us) { dma_us_.fetch_add(us, std::memory_order_relaxed); }
+  void add_dropped(uint32_t n) { dropped_.fetch_add(n, std::memory_order_relaxed); }
+  void add_spi(uint32_t busy_us, uint32_t txns) {
+    spi_us_.fetch_add(busy_us, std::memory_order_relaxed);
+    spi_txns_.fetch_add(txns, std::memory_order_relaxed);
+  }
+  void set_touch_latency(uint32_t us) { touch_us_.store(us, std::memory_order_relaxed); }
+  void set_feedback_latency(uint32_t us) { feedback_us_.store(us, std::memory_order_relaxed); }
+  void set_confirm_latency(uint32_t us) { confirm_us_.store(us, std::memory_order_relaxed); }
+  void add_rollback() { rollbacks_.fetch_add(1, std::memory_order_relaxed); }
+
+  // Fills out[PERF_COUNT] for the window since the last call and resets it.
+  void snapshot(uint32_t window_ms, uint32_t scratch_bytes, int wire_bytes_per_px, float* out) {
+    const float per_s = window_ms ? 1000.0f / window_ms : 0.0f;
+
+    uint32_t h[BUCKETS], total = 0;
+    for (int i = 0; i < BUCKETS; ++i) { h[i] = hist_[i].exchange(0, std::memory_order_relaxed); total += h[i]; }
+    out[PERF_LOOP_P50] = percentile_(h, total, 50);
+    out[PERF_LOOP_P95] = percentile_(h, total, 95);
+    out[PERF_LOOP_MAX] = loop_max_.exchange(0, std::memory_order_relaxed);
+
+    const uint32_t n = renders_.exchange(0, std::memory_order_relaxed);
+    const uint32_t r = render_us_.exchange(0, std::memory_order_relaxed);
+    out[PERF_RENDER_TIME] = n ? (float) r / n : 0.0f;
+
+    const uint32_t px = px_.exchange(0, std::memory_order_relaxed);
+    out[PERF_PIXELS] = px * per_s;
+    out[PERF_BYTES] = (float) px * wire_bytes_per_px * per_s;
+    out[PERF_DMA_WAIT] = dma_us_.exchange(0, std::memory_order_relaxed) * per_s;
+    out[PERF_TOUCH_LATENCY] = touch_us_.load(std::memory_order_relaxed);
+    out[PERF_FEEDBACK_LATENCY] = feedback_us_.load(std::memory_order_relaxed);
+    out[PERF_CONFIRM_LATENCY] = confirm_us_.load(std::memory_order_relaxed);
+    out[PERF_ROLLBACKS] = rollbacks_.exchange(0, std::memory_order_relaxed);
+    out[PERF_FPS] = frames_.exchange(0, std::memory_order_relaxed) * per_s;
+    out[PERF_DROPPED] = dropped_.exchange(0, std::memory_order_relaxed) * per_s;
+    out[PERF_SCRATCH_BYTES] = scratch_bytes;
+    out[PERF_SPI_BUSY] = window_ms ? spi_us_.exchange(0, std::memory_order_relaxed) / (10.0f * window_ms) : 0.0f;
+    out[PERF_SPI_TXNS] = spi_txns_.exchange(0, std::memory_order_relaxed) * per_s;
+  }
+
+private:
+  // Upper bounds (us) of the loop-duration histogram buckets; the last is open.
+  static constexpr int BUCKETS = 16;
+  static constexpr uint32_t EDGES[BUCKETS - 1] = {
+    100, 200, 300, 500, 750, 1000, 1500, 2000, 3000, 5000, 7500, 10000, 15000, 20000, 30000 };
+
+  std::atomic<uint32_t> hist_[BUCKETS]{};
+  std::atomic<uint32_t> loop_max_{0};
+  std::atomic<uint32_t> render_us_{0}, renders_{0};
+  std::atomic<uint32_t> px_{0}, frames_{0}, dropped_{0};
+  std::atomic<uint32_t> dma_us_{0};
+  std::atomic<uint32_t> touch_us_{0};
+  std::atomic<uint32_t> feedback_us_{0}, confirm_us_{0}, rollbacks_{0};
+  std::atomic<uint32_t> spi_us_{0}, spi_txns_{0};
+
+  static int bucket_(uint32_t us) {
+    int i = 0;
+    while (i < BUCKETS - 1 && us > EDGES[i]) ++i;
+    return i;
+  }
+
+  // Reported as the upper edge of the bucket holding the pct-th sample.
+  static float percentile_(const uint32_t* h, uint32_t total, int pct) {
+    if (!total) return 0.0f;
+    const uint32_t rank = (total * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKETS - 1; ++i) {
+      seen += h[i];
+      if (seen >= rank) return EDGES[i];
+    }
+    return EDGES[BUCKETS - 2] * 2.0f;
+  }
+};
+
+#else
+
+// Compiled out: every call is an empty inline, now() is a constant.
+class PerfStats {
+public:
+  uint32_t now() const { return 0; }
+  void add_loop(uint32_t) {}
+  void add_render(uint32_t) {}
+  void add_frame(uint32_t) {}
+  void add_dma_wait(uint32_t) {}
+  void add_dropped(uint32_t) {}
+  void add_spi(uint32_t, uint32_t) {}
+  void set_touch_latency(uint32_t) {}
+  void set_feedback_latency(uint32_t) {}
+  void set_confirm_latency(uint32_t) {}
+  void add_rollback() {}
+};
+
+#endif // TOUCH_PANEL_PERF
+
+} // namespace touch_panel
+
+#endif
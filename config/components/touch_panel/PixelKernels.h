@@ -0,0 +1,199 @@
+#include <cstdint>
+#include <cstring>
+
+#include <TFT_eSPI.h>
+
+#ifndef pixelKernels_h
+#define pixelKernels_h
+
+// ESP32-S3 PIE (128-bit SIMD) for the plain store/copy loops; define
+// TOUCH_PANEL_NO_SIMD to force the portable versions.
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(TOUCH_PANEL_NO_SIMD)
+#define TOUCH_PANEL_PIE 1
+#endif
+
+namespace touch_panel {
+namespace px {
+
+// ---------- Pixel kernels for the push path and sprite clears ----------
+// Sprite buffers:
+//   4 bit   two palette indices per byte, left pixel in the high nibble
+//   8 bit   RGB332
+//   16 bit  RGB565, byte swapped (the order it goes out on the wire)
+// Wire formats:
+//   16 bit  RGB565, big endian
+//   18 bit  RGB666 as three bytes R, G, B, colour in the top 6 bits (ILI9488 over SPI)
+// LUT entries for the 18-bit wire hold the three bytes as r | g << 8 | b << 16.
+//
+// The portable versions work a 32-bit word at a time; every kernel writes
+// exactly what the per-pixel conversion in TFT_eSPI would.
+
+// Byte-swapped RGB565 as stored in 16-bit sprites and sent on a 16-bit wire.
+inline uint16_t wire565(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+
+// RGB565 -> packed RGB666 wire bytes, as TFT_eSPI's 18-bit drivers expand it.
+inline uint32_t wire666(uint16_t c) {
+  return (uint32_t)((c & 0xF800) >> 8) | ((uint32_t)((c & 0x07E0) >> 3) << 8) | ((uint32_t)((c & 0x001F) << 3) << 16);
+}
+
+// Four packed RGB666 pixels -> 12 wire bytes.
+inline void store4_666_(uint8_t* dst, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  const uint32_t w[3] = { a | (b << 24), (b >> 8) | (c << 16), (c >> 16) | (d << 8) };
+  memcpy(dst, w, sizeof(w));
+}
+
+inline void store1_666_(uint8_t* dst, uint32_t v) {
+  dst[0] = (uint8_t) v; dst[1] = (uint8_t)(v >> 8); dst[2] = (uint8_t)(v >> 16);
+}
+
+// ---------- 8 bit -> wire ----------
+inline void expand8_565(const uint8_t* src, uint16_t* dst, int n, const uint16_t* lut) {
+  for (; n >= 4; n -= 4, src += 4, dst += 4) {
+    uint32_t s; memcpy(&s, src, 4);
+    const uint32_t w[2] = { lut[s & 0xFF] | ((uint32_t) lut[(s >> 8) & 0xFF] << 16),
+                            lut[(s >> 16) & 0xFF] | ((uint32_t) lut[s >> 24] << 16) };
+    memcpy(dst, w, sizeof(w));
+  }
+  while (n--) *dst++ = lut[*src++];
+}
+
+inline void expand8_666(const uint8_t* src, uint8_t* dst, int n, const uint32_t* lut) {
+  for (; n >= 4; n -= 4, src += 4, dst += 12) {
+    uint32_t s; memcpy(&s, src, 4);
+    store4_666_(dst, lut[s & 0xFF], lut[(s >> 8) & 0xFF], lut[(s >> 16) & 0xFF], lut[s >> 24]);
+  }
+  for (; n > 0; --n, dst += 3) store1_666_(dst, lut[*src++]);
+}
+
+// ---------- 4 bit -> wire ----------
+// Pixel p of a packed 4-bit image (rows back to back).
+inline int nibble_(const uint8_t* img, int p) {
+  const uint8_t b = img[p >> 1];
+  return (p & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+// lut2: both pixels of a byte, left one in the low half (see PushPipeline).
+inline void expand4_565(const uint8_t* img, int p, uint16_t* dst, int n, const uint32_t* lut2) {
+  if (n > 0 && (p & 1)) { *dst++ = (uint16_t)(lut2[img[p >> 1]] >> 16); ++p; --n; }
+  const uint8_t* src = img + (p >> 1);
+  for (; n >= 2; n -= 2, dst += 2) {
+    const uint32_t v = lut2[*src++];
+    memcpy(dst, &v, sizeof(v));
+  }
+  if (n) *dst = (uint16_t) lut2[*src];
+}
+
+inline void expand4_666(const uint8_t* img, int p, uint8_t* dst, int n, const uint32_t* lut) {
+  for (; n > 0 && (p & 1); --n, ++p, dst += 3) store1_666_(dst, lut[nibble_(img, p)]);
+  const uint8_t* src = img + (p >> 1);
+  for (; n >= 4; n -= 4, src += 2, dst += 12)
+    store4_666_(dst, lut[src[0] >> 4], lut[src[0] & 0x0F], lut[src[1] >> 4], lut[src[1] & 0x0F]);
+  for (p = 0; n > 0; --n, ++p, dst += 3) store1_666_(dst, lut[nibble_(src, p)]);
+}
+
+// ---------- 16 bit -> wire (the 16-bit wire is a plain copy, see copy16) ----------
+inline void expand16_666(const uint16_t* src, uint8_t* dst, int n) {
+  for (; n >= 4; n -= 4, src += 4, dst += 12)
+    store4_666_(dst, wire666(wire565(src[0])), wire666(wire565(src[1])),
+                     wire666(wire565(src[2])), wire666(wire565(src[3])));
+  for (; n > 0; --n, dst += 3) store1_666_(dst, wire666(wire565(*src++)));
+}
+
+// ---------- Fill / copy ----------
+#ifdef TOUCH_PANEL_PIE
+// 16-byte aligned blocks of 8 pixels through q0; the caller handles the edges.
+// q0 is loaded and stored in one statement: the compiler does not know about
+// the PIE registers, so nothing may be scheduled between the two.
+inline void pie_fill_(uint8_t* dst, uint32_t v2, int blocks) {
+  if (blocks <= 0) return;
+  asm volatile(
+    "ee.movi.32.q q0, %2, 0\n"
+    "ee.movi.32.q q0, %2, 1\n"
+    "ee.movi.32.q q0, %2, 2\n"
+    "ee.movi.32.q q0, %2, 3\n"
+    "1:\n"
+    "ee.vst.128.ip q0, %0, 16\n"
+    "addi %1, %1, -1\n"
+    "bnez %1, 1b\n"
+    : "+r"(dst), "+r"(blocks) : "r"(v2) : "memory");
+}
+
+inline void pie_copy_(const uint8_t* src, uint8_t* dst, int blocks) {
+  while (blocks--)
+    asm volatile("ee.vld.128.ip q0, %0, 16\n"
+                 "ee.vst.128.ip q0, %1, 16" : "+r"(src), "+r"(dst) :: "memory");
+}
+#endif
+
+// n 16-bit pixels of v (already in buffer byte order).
+inline void fill16(uint16_t* dst, uint16_t v, int n) {
+  for (; n > 0 && ((uintptr_t) dst & 3); --n) *dst++ = v;
+  const uint32_t v2 = v | ((uint32_t) v << 16);
+#ifdef TOUCH_PANEL_PIE
+  for (; n >= 2 && ((uintptr_t) dst & 15); n -= 2, dst += 2) memcpy(dst, &v2, 4);
+  if (n >= 8) {
+    pie_fill_((uint8_t*) dst, v2, n >> 3);
+    dst += n & ~7;
+    n &= 7;
+  }
+#endif
+  for (; n >= 2; n -= 2, dst += 2) memcpy(dst, &v2, 4);
+  if (n) *dst = v;
+}
+
+inline void copy16(const uint16_t* src, uint16_t* dst, int n) {
+#ifdef TOUCH_PANEL_PIE
+  // Only when both sides share the 16-byte alignment (full-width bands do).
+  if (n >= 16 && (((uintptr_t) src ^ (uintptr_t) dst) & 15) == 0) {
+    for (; n > 0 && ((uintptr_t) dst & 15); --n) *dst++ = *src++;
+    pie_copy_((const uint8_t*) src, (uint8_t*) dst, n >> 3);
+    src += n & ~7; dst += n & ~7;
+    n &= 7;
+  }
+#endif
+  memcpy(dst, src, n * sizeof(uint16_t));
+}
+
+// copy16() that leaves dst alone where src is 0, i.e. black in every sprite
+// depth once converted: black is the colour sprites are cleared to, so it is
+// the compositor's transparent key. Word-wide skip of black pixel pairs.
+inline void copy16_over(const uint16_t* src, uint16_t* dst, int n) {
+  for (; n >= 2; n -= 2, src += 2, dst += 2) {
+    uint32_t v;
+    memcpy(&v, src, 4);
+    if (!v) continue;
+    if (src[0]) dst[0] = src[0];
+    if (src[1]) dst[1] = src[1];
+  }
+  if (n && *src) *dst = *src;
+}
+
+// Solid rectangle in a sprite's buffer; colour is RGB565 (16 bit), RGB332 or
+// a palette index, as the sprite's own fillRect() takes it. Clipped to the sprite.
+inline void fill_rect(TFT_eSprite& spr, int x, int y, int w, int h, uint16_t color) {
+  const int sw = spr.width(), sh = spr.height();
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > sw) w = sw - x;
+  if (y + h > sh) h = sh - y;
+  if (w <= 0 || h <= 0) return;
+  const int depth = spr.getColorDepth();
+  if (depth == 16) {
+    const uint16_t v = wire565(color);
+    uint16_t* row = (uint16_t*) spr.getPointer() + y * sw + x;
+    for (int r = 0; r < h; ++r, row += sw) fill16(row, v, w);
+  } else if (depth == 8) {
+    // TFT_eSprite converts RGB565 arguments; keep its mapping.
+    const uint8_t v = (uint8_t)(((color & 0xE000) >> 8) | ((color & 0x0700) >> 6) | ((color & 0x0018) >> 3));
+    uint8_t* row = (uint8_t*) spr.getPointer() + y * sw + x;
+    if (w == sw) memset(row, v, w * h);
+    else for (int r = 0; r < h; ++r, row += sw) memset(row, v, w);
+  } else {
+    spr.fillRect(x, y, w, h, color);
+  }
+}
+
+} // namespace px
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include <TFT_eSPI.h>
+
+#ifdef TFT_eSPI_ENABLE_DMA
+#include <esp_heap_caps.h>
+#endif
+
+#include "PanelItem.h"
+#include "PixelKernels.h"
+
+#ifndef pushPipeline_h
+#define pushPipeline_h
+
+namespace touch_panel {
+
+// Bytes per pixel on the SPI wire: the ILI9488 only takes 18-bit colour over SPI.
+#ifdef ILI9488_DRIVER
+static constexpr int WIRE_BYTES_PER_PX = 3;
+#else
+static constexpr int WIRE_BYTES_PER_PX = 2;
+#endif
+
+// ---------- PushPipeline: sprite region -> display, double buffered over DMA ----------
+// A region is streamed in bands of rows. Each band is converted to the wire
+// format (see PixelKernels.h) into one of two DMA-capable buffers while the
+// other is still on the wire, so the CPU work of the next band/item overlaps
+// the SPI transfer. Conversion tables are sized to the sprite format: 16
+// palette entries for 4-bit, 256 RGB332 entries for 8-bit, none for 16-bit.
+// Without TFT_eSPI_ENABLE_DMA it degrades to a blocking pushSprite().
+//
+// Callers own the bus: push() must run between startWrite()/endWrite(), and
+// wait() must be called before the transaction is closed.
+class PushPipeline {
+public:
+  // Bytes per band buffer (x2 buffers): 2 * 16 KB of DMA RAM.
+  static constexpr int BUF_BYTES = 16384;
+  static constexpr int BUF_PX = BUF_BYTES / WIRE_BYTES_PER_PX;
+
+  explicit PushPipeline(TFT_eSPI& tft) : tft_(tft) {}
+  ~PushPipeline() { release_(); }
+
+  // Call once after tft.init(). Returns true when DMA streaming is active.
+  bool begin() {
+    // 8-bit sprites hold RGB332; pre-expand to the wire format.
+    for (int c = 0; c < 256; ++c) {
+      const uint16_t v = tft_.color8to16((uint8_t) c);
+      lut8_[c] = px::wire565(v);
+      lut8_666_[c] = px::wire666(v);
+    }
+#ifdef TFT_eSPI_ENABLE_DMA
+    if (dma_) return true;
+    for (int i = 0; i < 2; ++i) {
+      // +4: a band with an odd byte count is sent as whole 16-bit words.
+      buf_[i] = (uint8_t*) heap_caps_malloc(BUF_BYTES + 4, MALLOC_CAP_DMA);
+      if (!buf_[i]) { release_(); return false; }
+    }
+    dma_ = tft_.initDMA();
+    if (!dma_) release_();
+#endif
+    return dma_;
+  }
+
+  bool dma() const { return dma_; }
+
+  // Called between bands once the previous one has left the buffers; the
+  // bus may be lent to another device there (see SpiScheduler::gap()).
+  void set_gap(std::function<void()> fn) { gap_ = std::move(fn); }
+
+  // Copy (sx,sy,w,h) of spr to the screen at (x,y).
+  void push(TFT_eSprite& spr, int x, int y, int sx, int sy, int w, int h) {
+    const int depth = spr.getColorDepth();
+    if (!dma_ || w <= 0 || h <= 0 || (depth != 4 && depth != 8 && depth != 16)) {
+      spr.pushSprite(x, y, sx, sy, w, h);
+      return;
+    }
+#ifdef TFT_eSPI_ENABLE_DMA
+    if (depth == 4) load_palette_(spr);
+    const int rows = std::max(1, BUF_PX / w);
+    // Buffers are already in wire byte order.
+    const bool swap = tft_.getSwapBytes();
+    tft_.setSwapBytes(false);
+    for (int r = 0; r < h; r += rows) {
+      const int n = std::min(rows, h - r);
+      uint8_t* dst = buf_[next_];
+      next_ ^= 1;
+      pack_(spr, depth, sx, sy + r, w, n, dst);   // overlaps the band in flight
+      wait();                                      // for it, then start this one
+      if (gap_) gap_();
+      if (WIRE_BYTES_PER_PX == 2) {
+        tft_.pushImageDMA(x, y + r, w, n, (uint16_t*) dst);
+      } else {
+        // pushImageDMA() assumes 16-bit pixels; send the RGB666 bytes as they are.
+        // An odd trailing byte is never completed into a pixel, so it is harmless.
+        tft_.setAddrWindow(x, y + r, w, n);
+        tft_.pushPixelsDMA((uint16_t*) dst, (w * n * 3 + 1) / 2);
+      }
+    }
+    tft_.setSwapBytes(swap);
+#endif
+  }
+
+  // Block until the last band has left the buffers.
+  void wait() {
+#ifdef TFT_eSPI_ENABLE_DMA
+    if (!dma_) return;
+#ifdef TOUCH_PANEL_PERF
+    const uint32_t t0 = micros();
+    tft_.dmaWait();
+    wait_us_ += micros() - t0;
+#else
+    tft_.dmaWait();
+#endif
+#endif
+  }
+
+  // Time spent blocked in wait() since the last call (TOUCH_PANEL_PERF only).
+  uint32_t take_wait_us() {
+    const uint32_t us = wait_us_;
+    wait_us_ = 0;
+    return us;
+  }
+
+  // Converts n rows of (sx,sy,w) into the wire format at dst without sending
+  // anything; used by the benchmark to time the kernels on their own.
+  void pack(TFT_eSprite& spr, int sx, int sy, int w, int n, uint8_t* dst) {
+    if (spr.getColorDepth() == 4) load_palette_(spr);
+    pack_(spr, spr.getColorDepth(), sx, sy, w, n, dst);
+  }
+
+  // Copies (sx,sy,w,h) of src to (dx,dy) of a 16-bit sprite, converting
+  // from src's depth with the same tables as the push (page cache updates).
+  void copy_to16(TFT_eSprite& src, int sx, int sy, int w, int h, TFT_eSprite& dst, int dx, int dy) {
+    if (dst.getColorDepth() != 16 || w <= 0 || h <= 0) return;
+    const int depth = src.getColorDepth();
+    if (depth == 4) load_palette_(src);
+    const int ss = src.width(), ds = dst.width();
+    uint16_t* out = (uint16_t*) dst.getPointer() + dy * ds + dx;
+    for (int row = 0; row < h; ++row, out += ds) {
+      const int p = (sy + row) * ss + sx;
+      if (depth == 16)     px::copy16((const uint16_t*) src.getPointer() + p, out, w);
+      else if (depth == 8) px::expand8_565((const uint8_t*) src.getPointer() + p, out, w, lut8_);
+      else if (depth == 4) px::expand4_565((const uint8_t*) src.getPointer(), p, out, w, lut4x2_);
+    }
+  }
+
+  // copy_to16() with black pixels of src left out, so dst shows through
+  // (compositor overlays). 8/4-bit rows are converted in chunks on the stack.
+  void copy_over16(TFT_eSprite& src, int sx, int sy, int w, int h, TFT_eSprite& dst, int dx, int dy) {
+    if (dst.getColorDepth() != 16 || w <= 0 || h <= 0) return;
+    const int depth = src.getColorDepth();
+    if (depth == 4) load_palette_(src);
+    const int ss = src.width(), ds = dst.width();
+    uint16_t* out = (uint16_t*) dst.getPointer() + dy * ds + dx;
+    uint16_t tmp[64];
+    for (int row = 0; row < h; ++row, out += ds) {
+      const int p = (sy + row) * ss + sx;
+      if (depth == 16) { px::copy16_over((const uint16_t*) src.getPointer() + p, out, w); continue; }
+      for (int x = 0; x < w; x += 64) {
+        const int n = std::min(64, w - x);
+        if (depth == 8) px::expand8_565((const uint8_t*) src.getPointer() + p + x, tmp, n, lut8_);
+        else            px::expand4_565((const uint8_t*) src.getPointer(), p + x, tmp, n, lut4x2_);
+        px::copy16_over(tmp, out + x, n);
+      }
+    }
+  }
+
+private:
+  TFT_eSPI& tft_;
+  bool dma_{false};
+  uint8_t* buf_[2]{nullptr, nullptr};
+  int next_{0};
+  uint16_t lut8_[256];
+  uint32_t lut8_666_[256];
+  // 4-bit: palette of the last 4-bit sprite pushed, both pixels of a byte
+  // (16-bit wire) and single pixels (18-bit wire).
+  uint16_t pal4_[16]{};
+  uint32_t lut4x2_[256];
+  uint32_t lut4_666_[16];
+  bool pal4_valid_{false};
+  uint32_t wait_us_{0};
+  std::function<void()> gap_;
+
+  // Rebuilds the 4-bit tables only when the palette differs from the last one.
+  void load_palette_(TFT_eSprite& spr) {
+    uint16_t pal[16];
+    for (int i = 0; i < 16; ++i) pal[i] = spr.getPaletteColor(i);
+    if (pal4_valid_ && memcmp(pal, pal4_, sizeof(pal)) == 0) return;
+    memcpy(pal4_, pal, sizeof(pal));
+    uint16_t wire[16];
+    for (int i = 0; i < 16; ++i) {
+      wire[i] = px::wire565(pal[i]);
+      lut4_666_[i] = px::wire666(pal[i]);
+    }
+    // Buffer order: high nibble is the left pixel; little-endian store puts it first.
+    for (int b = 0; b < 256; ++b) lut4x2_[b] = wire[b >> 4] | ((uint32_t) wire[b & 15] << 16);
+    pal4_valid_ = true;
+  }
+
+  void pack_(TFT_eSprite& spr, int depth, int sx, int sy, int w, int n, uint8_t* dst) const {
+    const int stride = spr.width();
+    const int row_bytes = w * WIRE_BYTES_PER_PX;
+    if (depth == 4) {
+      // Rows are packed back to back; p is the first pixel's index in the image.
+      const uint8_t* img = (const uint8_t*) spr.getPointer();
+      for (int row = 0; row < n; ++row, dst += row_bytes) {
+        const int p = (sy + row) * stride + sx;
+        if (WIRE_BYTES_PER_PX == 2) px::expand4_565(img, p, (uint16_t*) dst, w, lut4x2_);
+        else                        px::expand4_666(img, p, dst, w, lut4_666_);
+      }
+      return;
+    }
+    if (depth == 16) {
+      const uint16_t* src = (const uint16_t*) spr.getPointer() + sy * stride + sx;
+      if (WIRE_BYTES_PER_PX == 2 && w == stride) { px::copy16(src, (uint16_t*) dst, w * n); return; }
+      for (int row = 0; row < n; ++row, src += stride, dst += row_bytes) {
+        if (WIRE_BYTES_PER_PX == 2) px::copy16(src, (uint16_t*) dst, w);
+        else                        px::expand16_666(src, dst, w);
+      }
+      return;
+    }
+    const uint8_t* src = (const uint8_t*) spr.getPointer() + sy * stride + sx;
+    for (int row = 0; row < n; ++row, src += stride, dst += row_bytes) {
+      if (WIRE_BYTES_PER_PX == 2) px::expand8_565(src, (uint16_t*) dst, w, lut8_);
+      else                        px::expand8_666(src, dst, w, lut8_666_);
+    }
+  }
+
+  void release_() {
+#ifdef TFT_eSPI_ENABLE_DMA
+    if (dma_) { tft_.dmaWait(); tft_.deInitDMA(); }
+    for (auto*& b : buf_) { if (b) heap_caps_free(b); b = nullptr; }
+#endif
+    dma_ = false;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#include "PanelItem.h"
+#include "SpscQueue.h"
+
+#ifndef renderTask_h
+#define renderTask_h
+
+namespace touch_panel {
+
+// ---------- Commands from the ESPHome loop to the render thread ----------
+// Everything the public Panel API changes crosses over as one of these, so the
+// render thread is the only one touching items, the bus and the power state.
+struct PanelCommand {
+  enum Type : uint8_t { TIME, ENV, ITEM_STATE, SLEEP, READY, PAGE_STEP, BENCH };
+  Type type;
+  IPanelItem* item;   // ITEM_STATE
+  int32_t a, b, c;    // TIME: h/m/s, ITEM_STATE/SLEEP: a = on, PAGE_STEP: a = +1/-1, BENCH: a = iterations
+  float f0, f1;       // ENV: temperature/humidity
+};
+
+// Render thread -> ESPHome loop: click handlers must run where the rest of
+// ESPHome runs.
+using MainCallback = const std::function<void()>*;
+
+// ---------- RenderTask: runs a step function on its own thread ----------
+// On ESP32 a FreeRTOS task pinned to a core; elsewhere a std::thread, so the
+// queues and command handling can be exercised on a host.
+class RenderTask {
+public:
+  using Step = std::function<bool()>;   // returns true if it did work
+
+  ~RenderTask() { stop(); }
+
+  // False if the task could not be created (e.g. no internal RAM for its
+  // stack); the caller then has to run the steps itself.
+  bool start(Step step, int core = 0, uint32_t stack = 8192, int priority = 1) {
+    if (running_) return true;
+    step_ = std::move(step);
+    running_ = true;
+    done_ = false;
+#if defined(ESP32)
+    if (xTaskCreatePinnedToCore(&RenderTask::entry_, "touch_panel", stack, this, priority, &handle_, core) != pdPASS) {
+      running_ = false;
+      done_ = true;
+      return false;
+    }
+#else
+    (void) core; (void) stack; (void) priority;
+    thread_ = std::thread([this](){ run_(); });
+#endif
+    return true;
+  }
+
+  void stop() {
+    if (!running_) return;
+    running_ = false;
+#if defined(ESP32)
+    while (!done_) vTaskDelay(1);
+#else
+    if (thread_.joinable()) thread_.join();
+#endif
+  }
+
+  bool running() const { return running_; }
+
+private:
+  Step step_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> done_{true};
+#if defined(ESP32)
+  TaskHandle_t handle_{nullptr};
+  static void entry_(void* self) {
+    static_cast<RenderTask*>(self)->run_();
+    vTaskDelete(nullptr);
+  }
+#else
+  std::thread thread_;
+#endif
+
+  void run_() {
+    while (running_) {
+      const bool busy = step_();
+      // Yield to lower-priority tasks (idle/watchdog) either way; back off when idle.
+      sleep_ms_(busy ? 1 : 5);
+    }
+    done_ = true;
+  }
+
+  static void sleep_ms_(uint32_t ms) {
+#if defined(ESP32)
+    vTaskDelay(pdMS_TO_TICKS(ms) ? pdMS_TO_TICKS(ms) : 1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+  }
+};
+
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,133 @@
+#include <functional>
+#include <cstdint>
+
+#ifndef spiScheduler_h
+#define spiScheduler_h
+
+namespace touch_panel {
+
+// ---------- SpiScheduler: one owner for the bus the display and touch share ----------
+// Display writes run inside a display transaction (CS low) that stays open
+// across consecutive writes, LCD commands and a frame's pushes, and is only
+// closed when the touch controller needs the bus or at release(). Queued jobs
+// run highest priority first; touch samples may also run in the gaps between
+// DMA bursts of a long frame (gap()), so a drag keeps being sampled while the
+// page renders.
+//
+// Port is the bus itself, so a host stand-in can record the order of calls:
+//   void dma_wait();         block until display DMA has finished
+//   void begin_display();    deselect touch, startWrite()
+//   void end_display();      endWrite()
+//   uint32_t now_us();
+// Render step only: every call comes from one thread, so nothing is locked.
+template <typename Port>
+class SpiScheduler {
+public:
+  // Lower runs first. TOUCH jobs talk to the touch controller, the rest to the display.
+  enum Prio : uint8_t { PRIO_TOUCH, PRIO_COMMAND, PRIO_DISPLAY, PRIO_COUNT };
+  using Job = std::function<void()>;
+  static constexpr int QUEUE_LEN = 8;   // per priority
+
+  explicit SpiScheduler(Port& port) : port_(port) {}
+
+  // Runs fn in the display transaction, opening it if needed.
+  void display(const Job& fn) {
+    open_();
+    fn();
+  }
+  void open_display() { open_(); }
+
+  // Queues fn for run() (or gap(), for touch jobs). False if that queue is full.
+  bool post(Prio p, Job fn) {
+    Queue& q = q_[p];
+    if (q.n == QUEUE_LEN) return false;
+    q.jobs[(q.head + q.n++) % QUEUE_LEN] = std::move(fn);
+    return true;
+  }
+
+  // Runs every queued job in priority order. Display jobs share the open
+  // transaction, so commands are coalesced with the frame that follows.
+  void run() {
+    for (int p = 0; p < PRIO_COUNT; ++p) drain_((Prio) p);
+  }
+
+  // Between DMA bursts while a display transaction is open: runs queued
+  // touch jobs, then resumes the transaction. No bus traffic if none are queued.
+  void gap() {
+    if (!q_[PRIO_TOUCH].n) return;
+    const bool was_open = open_now_;
+    drain_(PRIO_TOUCH);
+    if (was_open) open_();
+  }
+
+  // Ends the display transaction (after its DMA) and frees the bus.
+  void release() { close_(); }
+
+  bool display_open() const { return open_now_; }
+
+  // Time the bus was held and CS assertions since the last call.
+  uint32_t take_busy_us() {
+    uint32_t us = busy_us_;
+    if (open_now_) {   // count the open transaction up to now
+      const uint32_t t = port_.now_us();
+      us += t - t_open_;
+      t_open_ = t;
+    }
+    busy_us_ = 0;
+    return us;
+  }
+  uint32_t take_transactions() {
+    const uint32_t n = txns_;
+    txns_ = 0;
+    return n;
+  }
+
+private:
+  struct Queue {
+    Job jobs[QUEUE_LEN];
+    int head{0}, n{0};
+  };
+
+  Port& port_;
+  Queue q_[PRIO_COUNT];
+  bool open_now_{false};
+  uint32_t t_open_{0};
+  uint32_t busy_us_{0};
+  uint32_t txns_{0};
+
+  void drain_(Prio p) {
+    Queue& q = q_[p];
+    while (q.n) {
+      Job fn = std::move(q.jobs[q.head]);
+      q.head = (q.head + 1) % QUEUE_LEN;
+      --q.n;
+      if (p != PRIO_TOUCH) { display(fn); continue; }
+      close_();
+      const uint32_t t0 = port_.now_us();
+      ++txns_;
+      fn();
+      busy_us_ += port_.now_us() - t0;
+    }
+  }
+
+  void open_() {
+    if (open_now_) return;
+    port_.dma_wait();
+    port_.begin_display();
+    open_now_ = true;
+    t_open_ = port_.now_us();
+    ++txns_;
+  }
+
+  void close_() {
+    if (!open_now_) return;
+    port_.dma_wait();
+    port_.end_display();
+    open_now_ = false;
+    busy_us_ += port_.now_us() - t_open_;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
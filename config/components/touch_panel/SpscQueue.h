@@ -0,0 +1,50 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef spscQueue_h
+#define spscQueue_h
+
+namespace touch_panel {
+
+// ---------- SpscQueue: lock-free single-producer / single-consumer ring ----------
+// Fixed capacity N (power of two). push() is only called from one thread (or
+// ISR-free producer context), pop() only from one other. No allocation.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+public:
+  // Returns false (and drops v) when full.
+  bool push(const T& v) {
+    const uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == N) return false;
+    buf_[h & (N - 1)] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& out) {
+    const uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return N; }
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
+
+} // namespace touch_panel
+
+#endif
@@ -0,0 +1,90 @@
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "PanelItem.h"
+
+#ifndef tileMap_h
+#define tileMap_h
+
+namespace touch_panel {
+
+// ---------- TileMap: damaged screen tiles for the compositor ----------
+// The screen is split into TILE x TILE tiles; one bit per tile, one word per
+// tile row (screens up to 32 tiles wide). Damage is tracked at tile
+// granularity and handed back as horizontal runs of damaged tiles, each of
+// which the panel pushes as one rectangle.
+class TileMap {
+public:
+  static constexpr int TILE = 32;
+
+  void set_size(int w, int h) {
+    w_ = w; h_ = h;
+    cols_ = std::min(32, (w + TILE - 1) / TILE);
+    rows_.assign((h + TILE - 1) / TILE, 0);
+  }
+
+  void clear() { std::fill(rows_.begin(), rows_.end(), 0u); }
+  void mark_all() { mark({0, 0, w_, h_}); }
+
+  // Marks every tile r touches (screen coordinates).
+  void mark(const Rect& r) {
+    int c0, c1, r0, r1;
+    if (!span_(r, c0, c1, r0, r1)) return;
+    const uint32_t m = mask_(c0, c1);
+    for (int row = r0; row <= r1; ++row) rows_[row] |= m;
+  }
+
+  bool any() const {
+    for (uint32_t m : rows_) if (m) return true;
+    return false;
+  }
+
+  // Does r overlap a damaged tile?
+  bool touches(const Rect& r) const {
+    int c0, c1, r0, r1;
+    if (!span_(r, c0, c1, r0, r1)) return false;
+    const uint32_t m = mask_(c0, c1);
+    for (int row = r0; row <= r1; ++row) if (rows_[row] & m) return true;
+    return false;
+  }
+
+  // f(Rect) for each run of adjacent damaged tiles in a tile row, clipped to the screen.
+  template <typename F>
+  void for_each_run(F&& f) const {
+    for (int row = 0; row < (int) rows_.size(); ++row) {
+      const uint32_t m = rows_[row];
+      int c = 0;
+      while (c < cols_) {
+        if (!(m >> c & 1u)) { ++c; continue; }
+        const int c0 = c;
+        while (c < cols_ && (m >> c & 1u)) ++c;
+        const int x = c0 * TILE, y = row * TILE;
+        f(Rect{x, y, std::min(c * TILE, w_) - x, std::min(y + TILE, h_) - y});
+      }
+    }
+  }
+
+private:
+  int w_{0}, h_{0}, cols_{0};
+  std::vector<uint32_t> rows_;
+
+  bool span_(const Rect& r, int& c0, int& c1, int& r0, int& r1) const {
+    const Rect c = intersect(r, {0, 0, w_, h_});
+    if (empty(c)) return false;
+    c0 = c.x / TILE;
+    c1 = std::min(cols_ - 1, (c.x + c.w - 1) / TILE);
+    r0 = c.y / TILE;
+    r1 = (c.y + c.h - 1) / TILE;
+    return true;
+  }
+
+  static uint32_t mask_(int c0, int c1) {
+    const uint32_t hi = c1 >= 31 ? ~0u : (1u << (c1 + 1)) - 1;
+    return hi & ~((1u << c0) - 1);
+  }
+};
+
+} // namespace touch_panel
+
+#endif
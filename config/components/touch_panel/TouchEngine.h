@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "PanelItem.h"
+#include "SpscQueue.h"
+
+#ifndef touchEngine_h
+#define touchEngine_h
+
+namespace touch_panel {
+
+// ---------- TouchEngine: raw samples -> filtered position -> discrete events ----------
+// Pure logic, no bus access: the panel reads the controller only when the
+// XPT2046 IRQ has fired (or while the pen is down) and feeds every read here.
+// Positions are median-of-3 filtered, then smoothed with a 1/2 IIR. Events are
+// queued for the panel to dispatch on the next loop.
+//
+// A touch produces: PRESS, MOVE*, [LONG_PRESS], then one of CLICK / SWIPE_*
+// (unless it was a long press or a slow drag), then RELEASE.
+class TouchEngine {
+public:
+  struct Calibration { int x_min, x_max, y_min, y_max; };
+
+  static constexpr int      MOVE_MIN_PX     = 3;    // MOVE granularity
+  static constexpr int      TAP_SLOP_PX     = 12;   // more travel than this is not a tap
+  static constexpr int      SWIPE_MIN_PX    = 60;
+  static constexpr uint32_t SWIPE_MAX_MS    = 600;
+  static constexpr uint32_t LONG_PRESS_MS   = 700;
+  static constexpr int      RELEASE_SAMPLES = 2;    // consecutive "up" reads before release
+  static constexpr uint32_t POLL_MS         = 20;   // poll rate when there is no IRQ line
+
+  void set_calibration(int x_min, int x_max, int y_min, int y_max) {
+    cal_ = {x_min, x_max, y_min, y_max};
+  }
+
+  // Should the panel read the controller this loop?
+  bool wants_sample(uint32_t now, bool irq_flagged, bool has_irq) const {
+    if (down_) return true;
+    if (has_irq) return irq_flagged;
+    return now - last_poll_ >= POLL_MS;
+  }
+
+  // One controller read. raw_x/raw_y are the XPT2046 values, ignored when !down.
+  void feed(uint32_t now, bool down, int raw_x, int raw_y) {
+    last_poll_ = now;
+    if (!down) {
+      if (down_ && ++up_reads_ >= RELEASE_SAMPLES) release_(now);
+      return;
+    }
+    up_reads_ = 0;
+
+    int16_t x, y;
+    map_(raw_x, raw_y, x, y);
+    filter_(x, y);
+
+    if (!down_) {
+      down_ = true;
+      moved_ = long_ = false;
+      t0_ = now;
+      x0_ = lx_ = fx_; y0_ = ly_ = fy_;
+      emit_(TouchType::PRESS, fx_, fy_, 0, 0, now);
+      return;
+    }
+
+    const int dx = fx_ - lx_, dy = fy_ - ly_;
+    if (std::abs(dx) >= MOVE_MIN_PX || std::abs(dy) >= MOVE_MIN_PX) {
+      emit_(TouchType::MOVE, fx_, fy_, dx, dy, now);
+      lx_ = fx_; ly_ = fy_;
+    }
+    if (std::abs(fx_ - x0_) > TAP_SLOP_PX || std::abs(fy_ - y0_) > TAP_SLOP_PX) moved_ = true;
+    if (!moved_ && !long_ && now - t0_ >= LONG_PRESS_MS) {
+      long_ = true;
+      emit_(TouchType::LONG_PRESS, fx_, fy_, 0, 0, now);
+    }
+  }
+
+  bool pop(TouchEvent& e) { return events_.pop(e); }
+  bool down() const { return down_; }
+  uint32_t last_sample_ms() const { return last_poll_; }
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  Calibration cal_{200, 3800, 200, 3800};
+  SpscQueue<TouchEvent, 16> events_;
+  uint32_t dropped_{0};
+
+  bool down_{false}, moved_{false}, long_{false};
+  int up_reads_{0};
+  uint32_t t0_{0}, last_poll_{0};
+  int16_t x0_{0}, y0_{0};      // press position
+  int16_t lx_{0}, ly_{0};      // last MOVE position
+  int16_t fx_{0}, fy_{0};      // filtered position
+
+  // median-of-3 window
+  int16_t wx_[3]{}, wy_[3]{};
+  uint8_t wn_{0};
+
+  void map_(int raw_x, int raw_y, int16_t& x, int16_t& y) const {
+    // Panel is rotated: raw Y runs along the 480px axis.
+    long mx = (long)(raw_y - cal_.y_min) * 480 / (cal_.y_max - cal_.y_min);
+    long my = (long)(raw_x - cal_.x_min) * 320 / (cal_.x_max - cal_.x_min);
+    x = (int16_t) std::max<long>(0, std::min<long>(479, mx));
+    y = (int16_t) std::max<long>(0, std::min<long>(319, my));
+  }
+
+  static int16_t median3_(const int16_t* v) {
+    return std::max(std::min(v[0], v[1]), std::min(std::max(v[0], v[1]), v[2]));
+  }
+
+  void filter_(int16_t x, int16_t y) {
+    if (!down_) {
+      // New touch: seed the window so the first sample is used as-is.
+      wx_[0] = wx_[1] = wx_[2] = x;
+      wy_[0] = wy_[1] = wy_[2] = y;
+      wn_ = 0;
+      fx_ = x; fy_ = y;
+      return;
+    }
+    wx_[wn_] = x; wy_[wn_] = y;
+    wn_ = (wn_ + 1) % 3;
+    fx_ = (int16_t)((fx_ + median3_(wx_)) / 2);
+    fy_ = (int16_t)((fy_ + median3_(wy_)) / 2);
+  }
+
+  void release_(uint32_t now) {
+    const int dx = fx_ - x0_, dy = fy_ - y0_;
+    const bool fast = now - t0_ <= SWIPE_MAX_MS;
+    if (fast && std::max(std::abs(dx), std::abs(dy)) >= SWIPE_MIN_PX) {
+      TouchType t = std::abs(dx) >= std::abs(dy)
+          ? (dx < 0 ? TouchType::SWIPE_LEFT : TouchType::SWIPE_RIGHT)
+          : (dy < 0 ? TouchType::SWIPE_UP : TouchType::SWIPE_DOWN);
+      emit_(t, fx_, fy_, dx, dy, now);
+    } else if (!moved_ && !long_) {
+      emit_(TouchType::CLICK, fx_, fy_, 0, 0, now);
+    }
+    emit_(TouchType::RELEASE, fx_, fy_, dx, dy, now);
+    down_ = false;
+    up_reads_ = 0;
+  }
+
+  void emit_(TouchType t, int16_t x, int16_t y, int dx, int dy, uint32_t now) {
+    if (!events_.push(TouchEvent{t, x, y, (int16_t) dx, (int16_t) dy, now})) ++dropped_;
+  }
+};
+
+} // namespace touch_panel
+
+#endif
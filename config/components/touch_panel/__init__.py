@@ -1,24 +1,250 @@
-from esphome import codegen as cg, config_validation as cv
-from esphome.const import CONF_ID
+from esphome import automation, codegen as cg, config_validation as cv
+from esphome.components import light, sensor, switch
+from esphome.const import (
+    CONF_ID,
+    CONF_MAX_VALUE,
+    CONF_MIN_VALUE,
+    CONF_ON_CLICK,
+    CONF_RESOLUTION,
+    CONF_SENSOR_ID,
+    CONF_TRIGGER_ID,
+    CONF_TYPE,
+    CONF_UPDATE_INTERVAL,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+)
+from esphome.helpers import cpp_string_escape
 import esphome.config_validation as cv
 
+AUTO_LOAD = ["sensor"]
+
 touch_ns = cg.esphome_ns.namespace('touch_panel')
 TouchPanel = touch_ns.class_('Panel', cg.Component)
+PerfMetric = touch_ns.enum('PerfMetric')
+ItemClickTrigger = touch_ns.class_('ItemClickTrigger', automation.Trigger.template())
+
+CONF_SWITCH_ID = "switch_id"
+CONF_LIGHT_ID = "light_id"
+CONF_TEMPERATURE_ID = "temperature_id"
+CONF_HUMIDITY_ID = "humidity_id"
+CONF_ENTRIES = "entries"
+CONF_SPAN = "span"
+
+# Entity bindings, by the item base class they need (see Binding.h).
+TOGGLE_BINDING = {
+    cv.Optional(CONF_SWITCH_ID): cv.use_id(switch.Switch),
+    cv.Optional(CONF_LIGHT_ID): cv.use_id(light.LightState),
+}
+ENV_BINDING = {
+    cv.Optional(CONF_TEMPERATURE_ID): cv.use_id(sensor.Sensor),
+    cv.Optional(CONF_HUMIDITY_ID): cv.use_id(sensor.Sensor),
+}
+# Stored in flash; on_click handlers read the clicked one with id(x).Selected().
+LIST_ENTRIES = {
+    cv.Required(CONF_ENTRIES): cv.All(cv.ensure_list(cv.string), cv.Length(min=1)),
+}
+
+# Without min_value/max_value the range follows the data.
+CHART_OPTIONS = {
+    cv.Optional(CONF_SENSOR_ID): cv.use_id(sensor.Sensor),
+    cv.Optional(CONF_SPAN, default="4h"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_MIN_VALUE): cv.float_,
+    cv.Optional(CONF_MAX_VALUE): cv.float_,
+    cv.Optional(CONF_RESOLUTION, default=0.1): cv.positive_float,
+}
+
+# Range the arc spans; values outside it pin the arc to an end.
+GAUGE_OPTIONS = {
+    cv.Optional(CONF_SENSOR_ID): cv.use_id(sensor.Sensor),
+    cv.Optional(CONF_MIN_VALUE, default=0): cv.float_,
+    cv.Required(CONF_MAX_VALUE): cv.float_,
+    cv.Optional(CONF_RESOLUTION, default=1): cv.positive_float,
+}
+
+# type -> (class, takes a label, binding / per-type keys)
+ITEM_TYPES = {
+    "button": (touch_ns.class_('ButtonItem'), True, TOGGLE_BINDING),
+    "light": (touch_ns.class_('LightItem'), True, TOGGLE_BINDING),
+    "env": (touch_ns.class_('EnvItem'), False, ENV_BINDING),
+    "clock": (touch_ns.class_('ClockItem'), False, {}),
+    "analog_clock": (touch_ns.class_('AnalogClockItem'), False, {}),
+    "list": (touch_ns.class_('ListItem'), False, LIST_ENTRIES),
+    "chart": (touch_ns.class_('ChartItem'), True, CHART_OPTIONS),
+    "gauge": (touch_ns.class_('GaugeItem'), True, GAUGE_OPTIONS),
+}
+
+# Types that draw every colour through BaseItem::Ink(), so they can render
+# into a 4-bit (palette index) sprite; the others take 8 or 16 bit only.
+PALETTE_ITEM_TYPES = {"button", "light", "list"}
+
+# Must match Panel::setup() (rotation 3).
+SCREEN_W = 480
+SCREEN_H = 320
 
 CONF_TFT_CS = "tft_cs"
 CONF_TOUCH_CS = "touch_cs"
 CONF_TOUCH_IRQ = "touch_irq"
 CONF_COLS = "cols"
 CONF_ROWS = "rows"
+CONF_CALIBRATION = "calibration"
+CONF_X_MIN = "x_min"
+CONF_X_MAX = "x_max"
+CONF_Y_MIN = "y_min"
+CONF_Y_MAX = "y_max"
+CONF_SWIPE_PAGES = "swipe_pages"
+CONF_RENDER_BUDGET_US = "render_budget_us"
+CONF_FRAME_RATE = "frame_rate"
+CONF_PAGE_TRANSITION = "page_transition"
+CONF_COMPOSITOR = "compositor"
+CONF_SOLID_FILLS = "solid_fills"
+CONF_OPTIMISTIC_TIMEOUT = "optimistic_timeout"
+CONF_RENDER_TASK = "render_task"
+CONF_RENDER_CORE = "render_core"
+CONF_PAGE_CACHE_KB = "page_cache_kb"
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_ITEMS = "items"
+CONF_PAGE = "page"
+CONF_LABEL = "label"
+CONF_COL = "col"
+CONF_ROW = "row"
+CONF_COLSPAN = "colspan"
+CONF_ROWSPAN = "rowspan"
+CONF_COLOR_DEPTH = "color_depth"
+CONF_OPAQUE = "opaque"
+
+UNIT_MICROSECONDS = "µs"
+
+# diagnostics key -> (PerfMetric, unit, accuracy_decimals)
+PERF_SENSORS = {
+    "loop_time_p50": (PerfMetric.PERF_LOOP_P50, UNIT_MICROSECONDS, 0),
+    "loop_time_p95": (PerfMetric.PERF_LOOP_P95, UNIT_MICROSECONDS, 0),
+    "loop_time_max": (PerfMetric.PERF_LOOP_MAX, UNIT_MICROSECONDS, 0),
+    "render_time": (PerfMetric.PERF_RENDER_TIME, UNIT_MICROSECONDS, 0),
+    "pixels_pushed": (PerfMetric.PERF_PIXELS, "px/s", 0),
+    "bytes_pushed": (PerfMetric.PERF_BYTES, "B/s", 0),
+    "dma_wait": (PerfMetric.PERF_DMA_WAIT, "µs/s", 0),
+    "touch_latency": (PerfMetric.PERF_TOUCH_LATENCY, UNIT_MICROSECONDS, 0),
+    "feedback_latency": (PerfMetric.PERF_FEEDBACK_LATENCY, UNIT_MICROSECONDS, 0),
+    "confirm_latency": (PerfMetric.PERF_CONFIRM_LATENCY, UNIT_MICROSECONDS, 0),
+    "optimistic_rollbacks": (PerfMetric.PERF_ROLLBACKS, "clicks", 0),
+    "fps": (PerfMetric.PERF_FPS, "fps", 1),
+    "dropped_frames": (PerfMetric.PERF_DROPPED, "fps", 1),
+    "scratch_size": (PerfMetric.PERF_SCRATCH_BYTES, "B", 0),
+    "spi_utilization": (PerfMetric.PERF_SPI_BUSY, "%", 1),
+    "spi_transactions": (PerfMetric.PERF_SPI_TXNS, "1/s", 0),
+}
+
+DIAGNOSTICS_SCHEMA = cv.Schema({
+    cv.Optional(CONF_UPDATE_INTERVAL, default="10s"): cv.update_interval,
+    **{
+        cv.Optional(key): sensor.sensor_schema(
+            unit_of_measurement=unit,
+            accuracy_decimals=decimals,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        )
+        for key, (_, unit, decimals) in PERF_SENSORS.items()
+    },
+})
+
+CALIBRATION_SCHEMA = cv.Schema({
+    cv.Optional(CONF_X_MIN, default=200): cv.int_range(0, 4095),
+    cv.Optional(CONF_X_MAX, default=3800): cv.int_range(0, 4095),
+    cv.Optional(CONF_Y_MIN, default=200): cv.int_range(0, 4095),
+    cv.Optional(CONF_Y_MAX, default=3800): cv.int_range(0, 4095),
+})
+
+def _item_schema(cls, has_label, binding, depths):
+    schema = {
+        cv.Required(CONF_ID): cv.declare_id(cls),
+        cv.Required(CONF_COL): cv.int_range(min=0),
+        cv.Required(CONF_ROW): cv.int_range(min=0),
+        cv.Optional(CONF_COLSPAN, default=1): cv.int_range(min=1),
+        cv.Optional(CONF_ROWSPAN, default=1): cv.int_range(min=1),
+        cv.Optional(CONF_PAGE, default=0): cv.int_range(min=0),
+        cv.Optional(CONF_COLOR_DEPTH): cv.one_of(*depths, int=True),
+        # compositor: cover lower items with black too, not just drawn pixels
+        cv.Optional(CONF_OPAQUE, default=False): cv.boolean,
+        cv.Optional(CONF_ON_CLICK): automation.validate_automation({
+            cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(ItemClickTrigger),
+        }),
+    }
+    if has_label:
+        schema[cv.Required(CONF_LABEL)] = cv.string
+    schema.update(binding)
+    return cv.All(
+        cv.Schema(schema),
+        cv.has_at_most_one_key(CONF_SWITCH_ID, CONF_LIGHT_ID),
+        cv.has_none_or_all_keys(CONF_TEMPERATURE_ID, CONF_HUMIDITY_ID),
+        cv.has_none_or_all_keys(CONF_MIN_VALUE, CONF_MAX_VALUE),
+    )
 
-CONFIG_SCHEMA = cv.Schema({
+
+ITEM_SCHEMA = cv.typed_schema(
+    {name: _item_schema(cls, has_label, binding,
+                        (4, 8, 16) if name in PALETTE_ITEM_TYPES else (8, 16))
+     for name, (cls, has_label, binding) in ITEM_TYPES.items()},
+    lower=True,
+)
+
+
+def _validate_layout(config):
+    """Cells must lie inside the grid and, unless the compositor stacks them,
+    not overlap other items on their page."""
+    cols, rows = config[CONF_COLS], config[CONF_ROWS]
+    taken = {}
+    for item in config.get(CONF_ITEMS, []):
+        name = item[CONF_ID].id
+        c, r = item[CONF_COL], item[CONF_ROW]
+        cs, rs = item[CONF_COLSPAN], item[CONF_ROWSPAN]
+        if c + cs > cols or r + rs > rows:
+            raise cv.Invalid(f"item '{name}' ({c},{r} span {cs}x{rs}) does not fit the {cols}x{rows} grid")
+        if config[CONF_COMPOSITOR]:
+            continue
+        page = taken.setdefault(item[CONF_PAGE], {})
+        for cell in ((x, y) for x in range(c, c + cs) for y in range(r, r + rs)):
+            if cell in page:
+                raise cv.Invalid(f"item '{name}' overlaps '{page[cell]}' at cell {cell} on page {item[CONF_PAGE]}")
+            page[cell] = name
+    return config
+
+
+def _cell_rect(cols, rows, item):
+    """Same as Panel::cell_rect_()."""
+    cw, ch = SCREEN_W // cols, SCREEN_H // rows
+    return (item[CONF_COL] * cw + 1, item[CONF_ROW] * ch + 1,
+            cw * item[CONF_COLSPAN] - 2, ch * item[CONF_ROWSPAN] - 2)
+
+
+CONFIG_SCHEMA = cv.All(cv.Schema({
     cv.GenerateID(): cv.declare_id(TouchPanel),
     cv.Required(CONF_TFT_CS): cv.int_,
     cv.Required(CONF_TOUCH_CS): cv.int_,
     cv.Required(CONF_TOUCH_IRQ): cv.int_,
-    cv.Required(CONF_COLS): cv.int_,
-    cv.Required(CONF_ROWS): cv.int_,
-})
+    cv.Required(CONF_COLS): cv.int_range(min=1),
+    cv.Required(CONF_ROWS): cv.int_range(min=1),
+    cv.Optional(CONF_CALIBRATION): CALIBRATION_SCHEMA,
+    cv.Optional(CONF_SWIPE_PAGES, default=True): cv.boolean,
+    cv.Optional(CONF_RENDER_BUDGET_US, default=8000): cv.int_range(min=0),
+    # Tick()/render rate; 0 renders on every loop.
+    cv.Optional(CONF_FRAME_RATE, default=30): cv.int_range(min=0, max=120),
+    # Wipe to the next/previous page when its frame is cached (page_cache_kb).
+    # The tween that runs it counts in uint16_t milliseconds.
+    cv.Optional(CONF_PAGE_TRANSITION, default="0ms"): cv.All(
+        cv.positive_time_period_milliseconds,
+        cv.Range(max=cv.TimePeriod(milliseconds=65535)),
+    ),
+    cv.Optional(CONF_RENDER_TASK, default=False): cv.boolean,
+    cv.Optional(CONF_RENDER_CORE, default=0): cv.int_range(0, 1),
+    # PSRAM for composed page frames (300 KB per page at 480x320); 0 = off.
+    cv.Optional(CONF_PAGE_CACHE_KB, default=0): cv.int_range(min=0, max=8192),
+    # Overlapping items, later ones on top; one 300 KB PSRAM frame (shared with the page cache).
+    cv.Optional(CONF_COMPOSITOR, default=False): cv.boolean,
+    cv.Optional(CONF_SOLID_FILLS, default=False): cv.boolean,
+    cv.Optional(CONF_OPTIMISTIC_TIMEOUT, default="3s"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_DIAGNOSTICS): DIAGNOSTICS_SCHEMA,
+    cv.Optional(CONF_ITEMS): cv.ensure_list(ITEM_SCHEMA),
+}), _validate_layout)
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID],
@@ -28,3 +254,82 @@ async def to_code(config):
                            config[CONF_COLS],
                            config[CONF_ROWS])
     await cg.register_component(var, config)
+
+    if CONF_CALIBRATION in config:
+        cal = config[CONF_CALIBRATION]
+        cg.add(var.set_calibration(cal[CONF_X_MIN], cal[CONF_X_MAX],
+                                   cal[CONF_Y_MIN], cal[CONF_Y_MAX]))
+    cg.add(var.set_swipe_pages(config[CONF_SWIPE_PAGES]))
+    cg.add(var.set_render_budget_us(config[CONF_RENDER_BUDGET_US]))
+    cg.add(var.set_frame_rate(config[CONF_FRAME_RATE]))
+    if config[CONF_PAGE_TRANSITION].total_milliseconds:
+        cg.add(var.set_page_transition_ms(config[CONF_PAGE_TRANSITION]))
+    if config[CONF_PAGE_CACHE_KB]:
+        cg.add(var.set_page_cache_kb(config[CONF_PAGE_CACHE_KB]))
+    if config[CONF_COMPOSITOR]:
+        cg.add(var.set_compositor(True))
+    if config[CONF_SOLID_FILLS]:
+        cg.add(var.set_solid_fills(True))
+    cg.add(var.set_optimistic_timeout_ms(config[CONF_OPTIMISTIC_TIMEOUT]))
+    if config[CONF_RENDER_TASK]:
+        cg.add(var.set_render_task(True, config[CONF_RENDER_CORE]))
+
+    # Counters are only compiled in when diagnostics are configured.
+    if CONF_DIAGNOSTICS in config:
+        diag = config[CONF_DIAGNOSTICS]
+        cg.add_define("TOUCH_PANEL_PERF")
+        cg.add(var.set_perf_interval(diag[CONF_UPDATE_INTERVAL]))
+        for key, (metric, _, _) in PERF_SENSORS.items():
+            if key in diag:
+                sens = await sensor.new_sensor(diag[key])
+                cg.add(var.set_perf_sensor(metric, sens))
+
+    # Items are static objects with their bounds resolved here; the lambda
+    # API (add_item() from on_boot) still works alongside them.
+    for item in config.get(CONF_ITEMS, []):
+        item_id = item[CONF_ID]
+        cls, has_label, _ = ITEM_TYPES[item[CONF_TYPE]]
+        args = [cpp_string_escape(item_id.id)]
+        if has_label:
+            args.append(cpp_string_escape(item[CONF_LABEL]))
+        args.append(str(item[CONF_PAGE]))
+        storage = f"{item_id.id}__item"
+        cg.add_global(cg.RawStatement(f"static {cls} {storage}({', '.join(args)});"))
+        ptr = cg.Pvariable(item_id, cg.RawExpression(f"&{storage}"))
+
+        x, y, w, h = _cell_rect(config[CONF_COLS], config[CONF_ROWS], item)
+        rect = cg.RawExpression(f"touch_panel::Rect{{{x}, {y}, {w}, {h}}}")
+        cg.add(var.add_item(ptr, rect, item[CONF_PAGE], False))
+        if CONF_COLOR_DEPTH in item:
+            cg.add(ptr.SetColorDepth(item[CONF_COLOR_DEPTH]))
+        if item[CONF_OPAQUE]:
+            cg.add(ptr.SetOpaque(True))
+        if CONF_ENTRIES in item:
+            entries = item[CONF_ENTRIES]
+            array = f"{item_id.id}__entries"
+            cg.add_global(cg.RawStatement(
+                f"static const char* const {array}[] = {{{', '.join(cpp_string_escape(e) for e in entries)}}};"))
+            cg.add(ptr.SetEntries(cg.RawExpression(array), len(entries)))
+        if CONF_SPAN in item:
+            cg.add(ptr.SetSpan(item[CONF_SPAN]))
+            cg.add(ptr.SetResolution(item[CONF_RESOLUTION]))
+            if CONF_MIN_VALUE in item:
+                cg.add(ptr.SetRange(item[CONF_MIN_VALUE], item[CONF_MAX_VALUE]))
+        elif item[CONF_TYPE] == "gauge":
+            cg.add(ptr.SetRange(item[CONF_MIN_VALUE], item[CONF_MAX_VALUE]))
+            cg.add(ptr.SetResolution(item[CONF_RESOLUTION]))
+
+        if CONF_SWITCH_ID in item:
+            cg.add(var.bind_switch(ptr, await cg.get_variable(item[CONF_SWITCH_ID])))
+        if CONF_LIGHT_ID in item:
+            cg.add(var.bind_light(ptr, await cg.get_variable(item[CONF_LIGHT_ID])))
+        if CONF_TEMPERATURE_ID in item:
+            cg.add(var.bind_env(ptr, await cg.get_variable(item[CONF_TEMPERATURE_ID]),
+                                await cg.get_variable(item[CONF_HUMIDITY_ID])))
+        if CONF_SENSOR_ID in item:
+            bind = var.bind_gauge if item[CONF_TYPE] == "gauge" else var.bind_chart
+            cg.add(bind(ptr, await cg.get_variable(item[CONF_SENSOR_ID])))
+
+        for conf in item.get(CONF_ON_CLICK, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var, item_id.id)
+            await automation.build_automation(trigger, [], conf)
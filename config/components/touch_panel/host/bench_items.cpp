@@ -0,0 +1,135 @@
+// Item benchmark on the host stand-ins: a panel with one of each item is
+// driven through its entities and broadcasts, and every update is measured
+// on the simulated bus (bytes, windows, pixels reaching the glass) and in the
+// sprites (primitives, pixels drawn). Page switches and a sleep/wake-up
+// cycle follow, then Panel::benchmark()'s own per-item and full-page table.
+// Runs once per sprite depth; at 4 bit only the palette items (button, light,
+// list) are 4 bit, the rest run at 8. Fails if a frame's pixel count
+// disagrees with what reached the glass.
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include "harness.h"
+#include "panel.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+struct Cost {
+  TftStats s;
+  uint64_t us{0};
+  uint64_t px{0};   // pixels the panel says it pushed
+};
+
+// Render steps, summed: max_steps of them, or until one draws nothing.
+Cost measure(Panel& p, int max_steps = 4, bool until_idle = true) {
+  Cost c;
+  for (int i = 0; i < max_steps; ++i) {
+    host_advance_ms(FRAME_MS);
+    tft_stats().reset();
+    const uint64_t px0 = p.total_pixels();
+    const uint64_t t0 = host_now_us();
+    p.loop();
+    c.us += host_now_us() - t0;
+    const TftStats& s = tft_stats();
+    c.s.prims += s.prims; c.s.pixels += s.pixels; c.s.glass_px += s.glass_px;
+    c.s.spi_bytes += s.spi_bytes; c.s.windows += s.windows; c.s.dma += s.dma; c.s.txns += s.txns;
+    c.px += p.total_pixels() - px0;
+    if (until_idle && i > 0 && p.total_pixels() == px0 && s.glass_px == 0) break;
+  }
+  return c;
+}
+
+void row(const char* what, const Cost& c, bool check = true) {
+  std::printf("  %-26s %8llu %7llu %9llu %9llu %9llu %7llu %5llu\n", what,
+              (unsigned long long) c.us, (unsigned long long) c.s.prims, (unsigned long long) c.s.pixels,
+              (unsigned long long) c.px, (unsigned long long) c.s.spi_bytes,
+              (unsigned long long) c.s.windows, (unsigned long long) c.s.txns);
+  if (check) expect(c.s.glass_px == c.px, "%s: panel counted %llu px, glass got %llu", what,
+                    (unsigned long long) c.px, (unsigned long long) c.s.glass_px);
+}
+
+void run(int depth) {
+  std::printf("\n== %d-bit sprites ==\n", depth);
+  Panel p(5, 9, 17, 3, 3);
+  p.set_render_budget_us(0);
+  p.setup();   // grid cells exist from here on, as for on_boot on the device
+
+  esphome::switch_::Switch sw;
+  esphome::light::LightState lamp_state;
+  esphome::sensor::Sensor temp, hum, co2, power;
+  static const char* const ENTRIES[] = {"Kitchen", "Hall", "Garage", "Porch", "Office", "Attic"};
+
+  auto* button = new ButtonItem("button", "Fan");
+  p.add_item(button, 0, 0);
+  p.bind_switch(button, &sw);
+  auto* lamp = new LightItem("light", "Lamp");
+  p.add_item(lamp, 1, 0);
+  p.bind_light(lamp, &lamp_state);
+  auto* env = new EnvItem("env");
+  p.add_item(env, 2, 0);
+  p.bind_env(env, &temp, &hum);
+  p.add_item(new ClockItem("clock"), 0, 1, 2, 1);
+  auto* gauge = new GaugeItem("gauge", "CO2");
+  gauge->SetRange(400, 2000);
+  p.add_item(gauge, 2, 1);
+  p.bind_gauge(gauge, &co2);
+  auto* chart = new ChartItem("chart", "Power");
+  p.add_item(chart, 0, 2, 2, 1);
+  p.bind_chart(chart, &power);
+  auto* list = new ListItem("list");
+  list->SetEntries(ENTRIES, 6);
+  p.add_item(list, 2, 2);
+  p.add_item(new AnalogClockItem("analog_clock", 1), 0, 0, 3, 3, 1);
+  for (const char* id : {"button", "light", "list"}) p.set_color_depth(id, depth);
+  for (const char* id : {"env", "clock", "gauge", "chart", "analog_clock"}) p.set_color_depth(id, std::max(depth, 8));
+
+  std::printf("  %-26s %8s %7s %9s %9s %9s %7s %5s\n", "update", "step us", "prims", "spr px",
+              "wire px", "bus B", "windows", "txns");
+  row("first frame, page 0", measure(p));
+
+  sw.publish_state(true);
+  row("switch on", measure(p));
+  lamp_state.remote_values.on = true;
+  lamp_state.publish_state();
+  row("light on", measure(p));
+  temp.publish_state(21.5f);
+  hum.publish_state(48.0f);
+  row("env 21.5 C / 48 %", measure(p));
+  p.set_time(12, 34, 56);
+  measure(p);
+  p.set_time(12, 34, 57);
+  row("clock +1 s", measure(p));
+  co2.publish_state(812);
+  measure(p);
+  co2.publish_state(845);
+  row("gauge +33 ppm", measure(p));
+  for (int i = 0; i < 8; ++i) { power.publish_state(100.0f + 20 * i); measure(p); }
+  power.publish_state(180);
+  row("chart sample", measure(p));
+
+  p.next_page();
+  row("page switch 0 -> 1", measure(p, 12), false);
+  p.set_time(12, 34, 58);
+  row("analog clock +1 s", measure(p));
+  p.prev_page();
+  row("page switch 1 -> 0", measure(p, 12), false);
+
+  p.request_sleep(true);
+  measure(p, 12, false);
+  p.request_sleep(false);
+  row("wake-up", measure(p, 12, false), false);
+
+  p.benchmark(20);
+}
+
+}  // namespace
+
+int main() {
+  for (int depth : {4, 8, 16}) run(depth);
+  std::printf("\n");
+  return report();
+}
@@ -0,0 +1,46 @@
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+#include "Arduino.h"
+
+#ifndef harness_h
+#define harness_h
+
+// ---------- Shared pieces of the host tests ----------
+// Failure reporting and the simulated frame step, so every test counts,
+// prints and steps a panel the same way.
+namespace host_test {
+
+inline int failures = 0;
+
+// Records a failure unless ok; what is a printf format for the message.
+__attribute__((format(printf, 2, 3)))
+inline void expect(bool ok, const char* what, ...) {
+  if (ok) return;
+  std::va_list args;
+  va_start(args, what);
+  std::printf("FAIL ");
+  std::vprintf(what, args);
+  std::printf("\n");
+  va_end(args);
+  ++failures;
+}
+
+// Prints the verdict; main()'s exit code.
+inline int report() {
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
+
+constexpr uint32_t FRAME_MS = 34;   // just over one 30 fps slot
+
+// One loop() per simulated frame (the panel's render step when unthreaded).
+template <typename PanelT>
+void steps(PanelT& p, int n) {
+  for (int i = 0; i < n; ++i) { host_advance_ms(FRAME_MS); p.loop(); }
+}
+
+}  // namespace host_test
+
+#endif
@@ -0,0 +1,41 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#ifndef arduinoHost_h
+#define arduinoHost_h
+
+// ---------- Host stand-in for the Arduino core ----------
+// millis()/micros() follow the steady clock from program start, plus
+// whatever host_advance_ms() has skipped ahead (frame pacing and timeouts
+// without sleeping).
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+inline std::atomic<uint64_t>& host_clock_offset_us() { static std::atomic<uint64_t> us{0}; return us; }
+inline void host_advance_ms(uint32_t ms) { host_clock_offset_us() += (uint64_t) ms * 1000; }
+
+inline uint64_t host_now_us() {
+  using namespace std::chrono;
+  static const steady_clock::time_point t0 = steady_clock::now();
+  return (uint64_t) duration_cast<microseconds>(steady_clock::now() - t0).count() + host_clock_offset_us();
+}
+inline uint32_t micros() { return (uint32_t) host_now_us(); }
+inline uint32_t millis() { return (uint32_t)(host_now_us() / 1000); }
+inline void delay(uint32_t ms) { host_advance_ms(ms); }
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline long random(long n) { return n > 0 ? std::rand() % n : 0; }
+inline bool psramFound() { return true; }
+
+struct SPIClass { void begin(int, int, int) {} };
+static SPIClass SPI;
+
+#endif
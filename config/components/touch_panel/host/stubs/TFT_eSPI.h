@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Arduino.h"
+
+#ifndef tftEspiHost_h
+#define tftEspiHost_h
+
+// ---------- Host stand-in for TFT_eSPI / TFT_eSprite ----------
+// Enough of Bodmer's API for the touch_panel headers, with real behaviour:
+// sprites are 4/8/16-bit buffers in TFT_eSPI's own layouts (byte-swapped
+// RGB565, RGB332, two palette indices per byte), the panel is a 480x320
+// RGB565 frame ("glass"), and every primitive is rasterised into one or the
+// other. Fonts are a fixed-width stand-in: metrics per font number, one
+// deterministic pattern per character.
+//
+// tft_stats() counts primitives, pixels written and the bytes that would
+// cross the SPI bus: pixel data in the wire format (3 bytes with
+// ILI9488_DRIVER, else 2) plus 11 bytes of CASET/PASET/RAMWR per window.
+
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_DARKGREEN   0x03E0
+#define TFT_MAROON      0x7800
+#define TFT_PURPLE      0x780F
+#define TFT_DARKGREY    0x7BEF
+#define TFT_LIGHTGREY   0xD69A
+#define TFT_SILVER      0xC618
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_WHITE       0xFFFF
+#define TFT_ORANGE      0xFDA0
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define PSRAM_ENABLE 3
+
+// User_Setup values of the device build.
+#define TFT_WIDTH  320
+#define TFT_HEIGHT 480
+#define TFT_SCLK   12
+#define TFT_MISO   13
+#define TFT_MOSI   11
+
+struct TftStats {
+  uint64_t prims{0};       // drawing calls, sprites and panel
+  uint64_t pixels{0};      // pixels written into sprite buffers
+  uint64_t glass_px{0};    // pixels written to the panel
+  uint64_t spi_bytes{0};   // bytes on the simulated bus
+  uint64_t windows{0};     // address windows opened on the panel
+  uint64_t dma{0};         // DMA transfers started
+  uint64_t txns{0};        // startWrite() that asserted CS
+  void reset() { *this = TftStats(); }
+};
+inline TftStats& tft_stats() { static TftStats s; return s; }
+
+class TFT_eSprite;
+
+class TFT_eSPI {
+public:
+#ifdef ILI9488_DRIVER
+  static constexpr int WIRE_BYTES = 3;
+#else
+  static constexpr int WIRE_BYTES = 2;
+#endif
+  static constexpr int WINDOW_BYTES = 11;
+  static constexpr int GLASS_W = 480, GLASS_H = 320;
+
+  TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT) : w_(w), h_(h), native_w_(w), native_h_(h) {}
+  virtual ~TFT_eSPI() { if (panel() == this) panel() = nullptr; }
+
+  // ---------- Panel ----------
+  void init() { glass_.assign(GLASS_W * GLASS_H, 0); panel() = this; }
+  void setRotation(uint8_t r) {
+    const bool swap = r & 1;
+    w_ = swap ? native_h_ : native_w_;
+    h_ = swap ? native_w_ : native_h_;
+  }
+  void invertDisplay(bool) { command_(1); }
+  void writecommand(uint8_t) { command_(1); }
+  void writedata(uint8_t) { command_(1); }
+  void setSwapBytes(bool on) { swap_ = on; }
+  bool getSwapBytes() { return swap_; }
+
+  void startWrite() { if (locked_++ == 0) tft_stats().txns++; }
+  void endWrite() { if (locked_ > 0) --locked_; }
+
+  bool initDMA(bool = false) { dma_ = true; return true; }
+  void deInitDMA() { dma_ = false; }
+  bool dmaBusy() { return false; }
+  void dmaWait() {}
+
+  void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h) {
+    win_ = {x, y, w, h};
+    win_pos_ = 0;
+    win_part_ = 0;
+    tft_stats().windows++;
+    tft_stats().spi_bytes += WINDOW_BYTES;
+  }
+  void setWindow(int32_t x0, int32_t y0, int32_t x1, int32_t y1) { setAddrWindow(x0, y0, x1 - x0 + 1, y1 - y0 + 1); }
+
+  // len 16-bit words of the buffer go out as they are in memory.
+  void pushPixelsDMA(uint16_t* data, uint32_t len) {
+    tft_stats().dma++;
+    stream_((const uint8_t*) data, len * 2);
+  }
+  void pushPixels(const void* data, uint32_t len) { stream_((const uint8_t*) data, len * 2); }
+
+  // 16-bit pixels; byte-swapped in memory unless setSwapBytes(true).
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t* = nullptr) {
+    tft_stats().dma++;
+    pushImage(x, y, w, h, (const uint16_t*) data);
+  }
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+    setAddrWindow(x, y, w, h);
+    for (int32_t i = 0; i < w * h; ++i) {
+      const uint16_t c = swap_ ? data[i] : swap16(data[i]);
+      put_glass_(x + i % w, y + i / w, c);
+    }
+    tft_stats().spi_bytes += (uint64_t) w * h * WIRE_BYTES;
+  }
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data) {
+    pushImage(x, y, w, h, (const uint16_t*) data);
+  }
+  void pushBlock(uint16_t color, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) window_px_(color);
+    tft_stats().spi_bytes += (uint64_t) n * WIRE_BYTES;
+  }
+
+  // RGB565 of the panel pixel at (x,y), as last written.
+  uint16_t glass(int x, int y) const {
+    if (x < 0 || y < 0 || x >= GLASS_W || y >= GLASS_H || glass_.empty()) return 0;
+    return glass_[y * GLASS_W + x];
+  }
+  uint16_t readPixel(int32_t x, int32_t y) { return glass(x, y); }
+  // The last panel init() was called on, so tests can reach the glass.
+  static TFT_eSPI*& panel() { static TFT_eSPI* p = nullptr; return p; }
+
+  // ---------- Drawing (panel or sprite) ----------
+  int16_t width() { return w_; }
+  int16_t height() { return h_; }
+  void setAttribute(uint8_t, uint8_t) {}
+
+  void fillScreen(uint32_t color) { prim_(); fill_all_(color); }
+  void drawPixel(int32_t x, int32_t y, uint32_t color) { prim_(); span_(x, y, 1, color); }
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { prim_(); span_(x, y, w, color); }
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { prim_(); rect_(x, y, 1, h, color); }
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) { prim_(); rect_(x, y, w, h, color); }
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    prim_();
+    span_(x, y, w, color);
+    span_(x, y + h - 1, w, color);
+    rect_(x, y + 1, 1, h - 2, color);
+    rect_(x + w - 1, y + 1, 1, h - 2, color);
+  }
+
+  void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+    prim_();
+    const int32_t dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    const int32_t dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int32_t err = dx + dy;
+    for (;;) {
+      span_(x0, y0, 1, color);
+      if (x0 == x1 && y0 == y1) break;
+      const int32_t e2 = 2 * err;
+      if (e2 >= dy) { err += dy; x0 += sx; }
+      if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+  }
+
+  void drawCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    prim_();
+    circle_(x0, y0, r, 0xF, color);
+  }
+  void fillCircle(int32_t x0, int32_t y0, int32_t r, uint32_t color) {
+    prim_();
+    span_(x0 - r, y0, 2 * r + 1, color);
+    fill_circle_(x0, y0, r, 3, 0, color);
+  }
+
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+    prim_();
+    r = std::min(r, std::min(w, h) / 2);
+    span_(x + r, y, w - 2 * r, color);
+    span_(x + r, y + h - 1, w - 2 * r, color);
+    rect_(x, y + r, 1, h - 2 * r, color);
+    rect_(x + w - 1, y + r, 1, h - 2 * r, color);
+    circle_(x + r, y + r, r, 1, color);
+    circle_(x + w - r - 1, y + r, r, 2, color);
+    circle_(x + w - r - 1, y + h - r - 1, r, 4, color);
+    circle_(x + r, y + h - r - 1, r, 8, color);
+  }
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+    prim_();
+    r = std::min(r, std::min(w, h) / 2);
+    rect_(x, y + r, w, h - 2 * r, color);
+    fill_circle_(x + r, y + h - r - 1, r, 1, w - 2 * r - 1, color);
+    fill_circle_(x + r, y + r, r, 2, w - 2 * r - 1, color);
+  }
+
+  void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+  }
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+    prim_();
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+    if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+    if (y0 == y2) {
+      const int32_t a = std::min(x0, std::min(x1, x2)), b = std::max(x0, std::max(x1, x2));
+      span_(a, y0, b - a + 1, color);
+      return;
+    }
+    for (int32_t y = y0; y <= y2; ++y) {
+      // Edge 0-2 against 0-1 (upper part) or 1-2 (lower part).
+      int32_t a = x0 + (int32_t)((int64_t)(x2 - x0) * (y - y0) / (y2 - y0));
+      int32_t b = y < y1 ? x0 + (int32_t)((int64_t)(x1 - x0) * (y - y0) / (y1 - y0))
+                : y1 == y2 ? x1 : x1 + (int32_t)((int64_t)(x2 - x1) * (y - y1) / (y2 - y1));
+      if (a > b) std::swap(a, b);
+      span_(a, y, b - a + 1, color);
+    }
+  }
+
+  // Clip to (x,y,w,h); with datum, coordinates are relative to its corner.
+  void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool datum = true) {
+    vp_ = {x, y, w, h};
+    vp_org_x_ = datum ? x : 0;
+    vp_org_y_ = datum ? y : 0;
+  }
+  void resetViewport() { vp_ = {0, 0, INT16_MAX, INT16_MAX}; vp_org_x_ = vp_org_y_ = 0; }
+
+  // ---------- Text ----------
+  void setTextColor(uint16_t fg) { fg_ = bg_ = fg; }
+  void setTextColor(uint16_t fg, uint16_t bg, bool = false) { fg_ = fg; bg_ = bg; }
+  void setTextDatum(uint8_t d) { datum_ = d; }
+  void setTextPadding(uint16_t w) { pad_ = w; }
+  void setTextFont(uint8_t f) { font_ = f; }
+
+  static int16_t fontHeight(int16_t font) {
+    switch (font) {
+      case 2: return 16;
+      case 4: return 26;
+      case 6: case 7: return 48;
+      case 8: return 75;
+      default: return 8;
+    }
+  }
+  int16_t fontHeight() { return fontHeight(font_); }
+  static int16_t charWidth(int16_t font) {
+    switch (font) {
+      case 2: return 8;
+      case 4: return 14;
+      case 6: return 24;
+      case 7: return 32;
+      case 8: return 55;
+      default: return 6;
+    }
+  }
+  int16_t textWidth(const char* s, uint8_t font) { return (int16_t)(strlen(s) * charWidth(font)); }
+  int16_t textWidth(const char* s) { return textWidth(s, font_); }
+
+  int16_t drawChar(uint16_t c, int32_t x, int32_t y, uint8_t font) {
+    prim_();
+    char_(c, x, y, font);
+    return charWidth(font);
+  }
+
+  int16_t drawString(const char* s, int32_t x, int32_t y, uint8_t font) {
+    prim_();
+    const int w = textWidth(s, font), h = fontHeight(font);
+    const int col = datum_ % 3, row = datum_ / 3;
+    x -= col == 1 ? w / 2 : col == 2 ? w : 0;
+    y -= row == 1 ? h / 2 : row == 2 ? h : 0;
+    if (pad_ > w && fg_ != bg_) {
+      // Padding as TFT_eSPI lays it out: after, around or before the text.
+      const int extra = pad_ - w;
+      const int before = col == 1 ? extra / 2 : col == 2 ? extra : 0;
+      for (int i = 0; i < h; ++i) {
+        span_(x - before, y + i, before, bg_);
+        span_(x + w, y + i, extra - before, bg_);
+      }
+    }
+    for (int32_t cx = x; *s; ++s, cx += charWidth(font)) char_((uint8_t) *s, cx, y, font);
+    return (int16_t) w;
+  }
+  int16_t drawString(const char* s, int32_t x, int32_t y) { return drawString(s, x, y, font_); }
+
+  // ---------- Colour conversions, as TFT_eSPI does them ----------
+  static uint16_t swap16(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+  uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+  }
+  static uint8_t color16to8(uint16_t c) {
+    return (uint8_t)(((c & 0xE000) >> 8) | ((c & 0x0700) >> 6) | ((c & 0x0018) >> 3));
+  }
+  static uint16_t color8to16(uint8_t c) {
+    static const uint8_t blue[] = {0, 11, 21, 31};
+    uint16_t v = (uint16_t)((c & 0x1C) << 6 | (c & 0xC0) << 5 | (c & 0xE0) << 8);
+    v |= (uint16_t)((c & 0x1C) << 3 | blue[c & 0x03]);
+    return v;
+  }
+
+protected:
+  struct Box { int32_t x, y, w, h; };
+  int16_t w_, h_;
+  Box vp_{0, 0, INT16_MAX, INT16_MAX};
+  int32_t vp_org_x_{0}, vp_org_y_{0};
+
+  static void prim_() { tft_stats().prims++; }
+
+  // A clipped solid rectangle; the only way drawing reaches a target.
+  void rect_(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    x += vp_org_x_;
+    y += vp_org_y_;
+    const int32_t x0 = std::max<int32_t>({x, vp_.x, 0});
+    const int32_t x1 = std::min<int32_t>({x + w, vp_.x + vp_.w, (int32_t) w_});
+    const int32_t y0 = std::max<int32_t>({y, vp_.y, 0});
+    const int32_t y1 = std::min<int32_t>({y + h, vp_.y + vp_.h, (int32_t) h_});
+    if (x0 < x1 && y0 < y1) put_rect_(x0, y0, x1 - x0, y1 - y0, color);
+  }
+  void span_(int32_t x, int32_t y, int32_t w, uint32_t color) { rect_(x, y, w, 1, color); }
+
+  // Panel: one window per rectangle.
+  virtual void put_rect_(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+    setAddrWindow(x, y, w, h);
+    pushBlock((uint16_t) color, (uint32_t) w * h);
+  }
+  void fill_all_(uint32_t color) { rect_(-vp_org_x_, -vp_org_y_, INT16_MAX, INT16_MAX, color); }
+
+private:
+  int16_t native_w_, native_h_;
+  std::vector<uint16_t> glass_;
+  bool swap_{false};
+  bool dma_{false};
+  int locked_{0};
+  Box win_{0, 0, 0, 0};
+  uint32_t win_pos_{0};
+  uint8_t win_part_{0}, win_acc_[3]{};
+  uint16_t fg_{TFT_WHITE}, bg_{TFT_WHITE};
+  uint8_t datum_{TL_DATUM};
+  uint8_t font_{1};
+  uint16_t pad_{0};
+
+  void command_(int bytes) { tft_stats().spi_bytes += bytes; }
+
+  void put_glass_(int32_t x, int32_t y, uint16_t c) {
+    if (glass_.empty()) glass_.assign(GLASS_W * GLASS_H, 0);
+    if (x < 0 || y < 0 || x >= GLASS_W || y >= GLASS_H) return;
+    glass_[y * GLASS_W + x] = c;
+    tft_stats().glass_px++;
+  }
+  void window_px_(uint16_t c) {
+    if (win_.w <= 0) return;
+    put_glass_(win_.x + win_pos_ % win_.w, win_.y + win_pos_ / win_.w, c);
+    ++win_pos_;
+  }
+  // Raw wire bytes into the open window: RGB666 triplets or big-endian RGB565.
+  void stream_(const uint8_t* p, uint32_t n) {
+    tft_stats().spi_bytes += n;
+    for (uint32_t i = 0; i < n; ++i) {
+      win_acc_[win_part_++] = p[i];
+      if (win_part_ < WIRE_BYTES) continue;
+      win_part_ = 0;
+      if (WIRE_BYTES == 3)
+        window_px_((uint16_t)((win_acc_[0] >> 3) << 11 | (win_acc_[1] >> 2) << 5 | (win_acc_[2] >> 3)));
+      else
+        window_px_((uint16_t)(win_acc_[0] << 8 | win_acc_[1]));
+    }
+  }
+
+  // Midpoint circle; corners is a mask of quadrants (1 TL, 2 TR, 4 BR, 8 BL).
+  void circle_(int32_t x0, int32_t y0, int32_t r, uint8_t corners, uint32_t color) {
+    int32_t f = 1 - r, dx = 1, dy = -2 * r, x = 0, y = r;
+    if (corners == 0xF) {
+      span_(x0, y0 + r, 1, color); span_(x0, y0 - r, 1, color);
+      span_(x0 + r, y0, 1, color); span_(x0 - r, y0, 1, color);
+    }
+    while (x < y) {
+      if (f >= 0) { --y; dy += 2; f += dy; }
+      ++x; dx += 2; f += dx;
+      if (corners & 4) { span_(x0 + x, y0 + y, 1, color); span_(x0 + y, y0 + x, 1, color); }
+      if (corners & 2) { span_(x0 + x, y0 - y, 1, color); span_(x0 + y, y0 - x, 1, color); }
+      if (corners & 8) { span_(x0 - y, y0 + x, 1, color); span_(x0 - x, y0 + y, 1, color); }
+      if (corners & 1) { span_(x0 - y, y0 - x, 1, color); span_(x0 - x, y0 - y, 1, color); }
+    }
+  }
+  // Filled halves of a circle stretched by delta: 1 lower, 2 upper.
+  void fill_circle_(int32_t x0, int32_t y0, int32_t r, uint8_t halves, int32_t delta, uint32_t color) {
+    int32_t f = 1 - r, dx = 1, dy = -2 * r, x = 0, y = r;
+    while (x < y) {
+      if (f >= 0) {
+        if (halves & 1) span_(x0 - x, y0 + y, 2 * x + 1 + delta, color);
+        if (halves & 2) span_(x0 - x, y0 - y, 2 * x + 1 + delta, color);
+        --y; dy += 2; f += dy;
+      }
+      ++x; dx += 2; f += dx;
+      if (halves & 1) span_(x0 - y, y0 + x, 2 * y + 1 + delta, color);
+      if (halves & 2) span_(x0 - y, y0 - x, 2 * y + 1 + delta, color);
+    }
+  }
+
+  // A character cell: background (unless transparent), then a pattern that
+  // only depends on the character, so the same text always rasterises alike.
+  void char_(uint16_t c, int32_t x, int32_t y, uint8_t font) {
+    const int w = charWidth(font), h = fontHeight(font);
+    if (fg_ != bg_) for (int i = 0; i < h; ++i) span_(x, y + i, w, bg_);
+    if (c == ' ') return;
+    for (int i = 1; i < h - 1; ++i) {
+      const uint32_t bits = (c * 2654435761u) >> (i % 24);
+      for (int j = 1; j < w - 1; ++j)
+        if (j == 1 || i == 1 || ((bits >> (j % 8)) & 1)) span_(x + j, y + i, 1, fg_);
+    }
+  }
+
+  friend class TFT_eSprite;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+  explicit TFT_eSprite(TFT_eSPI* tft) : TFT_eSPI(0, 0), tft_(tft) { w_ = h_ = 0; }
+  ~TFT_eSprite() override { deleteSprite(); }
+
+  void* setColorDepth(int8_t b) {
+    depth_ = (b == 4 || b == 16) ? b : 8;
+    if (!img_.empty()) return createSprite(w_, h_);
+    return nullptr;
+  }
+  int8_t getColorDepth() { return depth_; }
+
+  void* createSprite(int16_t w, int16_t h, uint8_t = 1) {
+    if (w <= 0 || h <= 0) return nullptr;
+    if (host_sprite_limit() && bytes_(w, h) > host_sprite_limit()) return nullptr;
+    w_ = w; h_ = h;
+    img_.assign(bytes_(w, h), 0);
+    if (depth_ == 4 && !palette_set_) createPalette((const uint16_t*) nullptr);
+    return img_.data();
+  }
+  void deleteSprite() { img_.clear(); img_.shrink_to_fit(); w_ = h_ = 0; }
+  bool created() { return !img_.empty(); }
+  void* getPointer() { return img_.empty() ? nullptr : img_.data(); }
+
+  // Sprites larger than this many bytes fail to allocate (0: no limit), to
+  // exercise the no-memory paths.
+  static size_t& host_sprite_limit() { static size_t n = 0; return n; }
+
+  void createPalette(const uint16_t* pal, uint8_t n = 16) {
+    static const uint16_t def[16] = {
+      TFT_BLACK, TFT_NAVY, TFT_DARKGREEN, TFT_DARKCYAN_, TFT_MAROON, TFT_PURPLE, TFT_OLIVE_, TFT_LIGHTGREY,
+      TFT_DARKGREY, TFT_BLUE, TFT_GREEN, TFT_CYAN, TFT_RED, TFT_MAGENTA, TFT_YELLOW, TFT_WHITE };
+    for (int i = 0; i < 16; ++i) pal_[i] = pal && i < n ? pal[i] : def[i];
+    palette_set_ = true;
+  }
+  void createPalette(uint16_t* pal, uint8_t n = 16) { createPalette((const uint16_t*) pal, n); }
+  void setPaletteColor(uint8_t i, uint16_t c) { pal_[i & 15] = c; }
+  uint16_t getPaletteColor(uint8_t i) { return pal_[i & 15]; }
+
+  void fillSprite(uint32_t color) { fillScreen(color); }
+
+  // RGB565 of the pixel at (x,y).
+  uint16_t readPixel(int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= w_ || y >= h_) return 0;
+    const size_t p = (size_t) y * w_ + x;
+    if (depth_ == 16) return swap16(((const uint16_t*) img_.data())[p]);
+    if (depth_ == 8) return color8to16(img_[p]);
+    const uint8_t b = img_[p >> 1];
+    return pal_[(p & 1) ? (b & 0x0F) : (b >> 4)];
+  }
+
+  // (sx,sy,w,h) of the sprite to the panel at (x,y): one window, all pixels.
+  bool pushSprite(int32_t x, int32_t y, int32_t sx, int32_t sy, int32_t w, int32_t h) {
+    prim_();
+    if (!tft_ || img_.empty()) return false;
+    tft_->setAddrWindow(x, y, w, h);
+    for (int32_t r = 0; r < h; ++r)
+      for (int32_t c = 0; c < w; ++c) tft_->window_px_(readPixel(sx + c, sy + r));
+    tft_stats().spi_bytes += (uint64_t) w * h * WIRE_BYTES;
+    return true;
+  }
+  void pushSprite(int32_t x, int32_t y) { pushSprite(x, y, 0, 0, w_, h_); }
+
+  // Into dst at (x,y): a raw copy between equal depths, else through RGB565.
+  bool pushToSprite(TFT_eSprite* dst, int32_t x, int32_t y) {
+    prim_();
+    if (img_.empty() || !dst || !dst->created()) return false;
+    for (int32_t r = 0; r < h_; ++r) {
+      const int32_t dy = y + r;
+      if (dy < 0 || dy >= dst->h_) continue;
+      if (depth_ == dst->depth_ && depth_ != 4 && x >= 0 && x + w_ <= dst->w_) {
+        const int bpp = depth_ / 8;
+        memcpy(&dst->img_[((size_t) dy * dst->w_ + x) * bpp], &img_[(size_t) r * w_ * bpp], (size_t) w_ * bpp);
+        tft_stats().pixels += w_;
+        continue;
+      }
+      for (int32_t c = 0; c < w_; ++c) {
+        const uint16_t v = readPixel(c, r);
+        dst->span_(x + c, dy, 1, dst->depth_ == 4 ? nearest_(dst, v) : v);
+      }
+    }
+    return true;
+  }
+
+  void scroll(int16_t, int16_t = 0) {}
+
+protected:
+  // Colour is RGB565, or a palette index for 4-bit sprites.
+  void put_rect_(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override {
+    if (img_.empty()) return;
+    tft_stats().pixels += (uint64_t) w * h;
+    for (int32_t r = y; r < y + h; ++r) {
+      const size_t p = (size_t) r * w_ + x;
+      if (depth_ == 16) {
+        std::fill_n((uint16_t*) img_.data() + p, w, swap16((uint16_t) color));
+      } else if (depth_ == 8) {
+        memset(&img_[p], color16to8((uint16_t) color), w);
+      } else {
+        const uint8_t i = color & 0x0F;
+        for (size_t q = p; q < p + w; ++q) {
+          uint8_t& b = img_[q >> 1];
+          b = (q & 1) ? (uint8_t)((b & 0xF0) | i) : (uint8_t)((b & 0x0F) | (i << 4));
+        }
+      }
+    }
+  }
+
+private:
+  static constexpr uint16_t TFT_DARKCYAN_ = 0x03EF, TFT_OLIVE_ = 0x7BE0;
+  TFT_eSPI* tft_;
+  int8_t depth_{8};
+  std::vector<uint8_t> img_;
+  uint16_t pal_[16]{};
+  bool palette_set_{false};
+
+  size_t bytes_(int w, int h) const {
+    return depth_ == 4 ? ((size_t) w * h + 1) / 2 : (size_t) w * h * (depth_ / 8);
+  }
+  static uint8_t nearest_(TFT_eSprite* s, uint16_t c) {
+    for (int i = 0; i < 16; ++i) if (s->pal_[i] == c) return (uint8_t) i;
+    return 0;
+  }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include <atomic>
+#include <cstdint>
+
+#ifndef xpt2046Host_h
+#define xpt2046Host_h
+
+// ---------- Host stand-in for XPT2046_Touchscreen ----------
+// Reports the last set_point() (raw controller units, z = 0 for no touch);
+// safe to drive from a test thread while the render task reads it.
+struct TS_Point {
+  int16_t x{0}, y{0}, z{0};
+};
+
+class XPT2046_Touchscreen {
+public:
+  XPT2046_Touchscreen(uint8_t, uint8_t = 255) { instance() = this; }
+  ~XPT2046_Touchscreen() { if (instance() == this) instance() = nullptr; }
+  bool begin() { return true; }
+  void setRotation(uint8_t) {}
+  TS_Point getPoint() {
+    reads_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t v = raw_.load(std::memory_order_acquire);
+    return {(int16_t) v, (int16_t)(v >> 16), (int16_t)(v >> 32)};
+  }
+  bool touched() { return getPoint().z > 0; }
+  bool tirqTouched() { return (raw_.load(std::memory_order_acquire) >> 32) != 0; }
+
+  void set_point(int16_t x, int16_t y, int16_t z) {
+    raw_.store((uint16_t) x | (uint64_t)(uint16_t) y << 16 | (uint64_t)(uint16_t) z << 32, std::memory_order_release);
+  }
+  uint32_t reads() const { return reads_.load(std::memory_order_relaxed); }
+
+  // The most recently constructed controller (the panel's).
+  static XPT2046_Touchscreen*& instance() { static XPT2046_Touchscreen* p = nullptr; return p; }
+
+private:
+  std::atomic<uint64_t> raw_{0};
+  std::atomic<uint32_t> reads_{0};
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include <cstddef>
+#include <cstdlib>
+
+#ifndef espHeapCapsHost_h
+#define espHeapCapsHost_h
+
+// ---------- Host stand-in for esp_heap_caps.h ----------
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT     (1 << 2)
+
+inline void* heap_caps_malloc(size_t n, unsigned) { return std::malloc(n); }
+inline void heap_caps_free(void* p) { std::free(p); }
+inline size_t heap_caps_get_free_size(unsigned) { return 8u << 20; }
+
+#endif
@@ -0,0 +1,111 @@
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+#ifndef esphomeHost_h
+#define esphomeHost_h
+
+// ---------- Host stand-in for the parts of ESPHome the panel uses ----------
+// Entities keep their callbacks and call them from publish_state(), so a
+// test can play the part of a switch, light or sensor. Logs go to stdout;
+// ESP_LOGV/ESP_LOGD only with host_log_verbose().
+
+inline bool& host_log_verbose() { static bool on = false; return on; }
+inline void host_log(char level, const char* tag, const char* fmt, ...) {
+  if ((level == 'V' || level == 'D') && !host_log_verbose()) return;
+  std::printf("[%c][%s] ", level, tag);
+  va_list ap;
+  va_start(ap, fmt);
+  std::vprintf(fmt, ap);
+  va_end(ap);
+  std::printf("\n");
+}
+#define ESP_LOGE(tag, ...) host_log('E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) host_log('W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) host_log('I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) host_log('D', tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) host_log('V', tag, __VA_ARGS__)
+
+namespace esphome {
+
+class Component {
+public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0; }
+
+  // Runs every set_interval() callback once, in place of the scheduler.
+  void host_fire_intervals() { for (auto& f : intervals_) f(); }
+
+protected:
+  void set_interval(const char*, uint32_t, std::function<void()> fn) { intervals_.push_back(std::move(fn)); }
+
+private:
+  std::vector<std::function<void()>> intervals_;
+};
+
+class PollingComponent : public Component {
+public:
+  explicit PollingComponent(uint32_t) {}
+  virtual void update() {}
+};
+
+template<typename... Ts> class Trigger {
+public:
+  void trigger(Ts... x) { ++count; (void) sizeof...(x); }
+  int count{0};
+};
+
+namespace sensor {
+class Sensor {
+public:
+  void add_on_state_callback(std::function<void(float)> fn) { cbs_.push_back(std::move(fn)); }
+  void publish_state(float v) { state = v; for (auto& f : cbs_) f(v); }
+  float state{NAN};
+private:
+  std::vector<std::function<void(float)>> cbs_;
+};
+}  // namespace sensor
+
+namespace switch_ {
+class Switch {
+public:
+  void add_on_state_callback(std::function<void(bool)> fn) { cbs_.push_back(std::move(fn)); }
+  void publish_state(bool on) { state = on; for (auto& f : cbs_) f(on); }
+  bool state{false};
+private:
+  std::vector<std::function<void(bool)>> cbs_;
+};
+}  // namespace switch_
+
+namespace light {
+class LightColorValues {
+public:
+  bool is_on() const { return on; }
+  bool on{false};
+};
+class LightState {
+public:
+  void add_new_remote_values_callback(std::function<void()> fn) { cbs_.push_back(std::move(fn)); }
+  void publish_state() { for (auto& f : cbs_) f(); }
+  LightColorValues remote_values;
+private:
+  std::vector<std::function<void()>> cbs_;
+};
+}  // namespace light
+
+namespace setup_priority {
+const float HARDWARE = 800, DATA = 600, PROCESSOR = 400, LATE = -100;
+}
+
+}  // namespace esphome
+
+#endif
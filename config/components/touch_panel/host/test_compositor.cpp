@@ -0,0 +1,60 @@
+// Compositor (Panel::set_compositor()) with a round badge over a larger
+// button: the badge's cell corners are black, the transparent key, so the
+// button must show through them; marked opaque, the badge covers its whole
+// cell. Plus copy16_over() against a per-pixel reference.
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "harness.h"
+#include "panel.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+void copy_over_kernel() {
+  std::vector<uint16_t> src(80), a(80), r(80);
+  for (int off = 0; off < 4; ++off) {
+    for (int n = 0; n <= 70; ++n) {
+      for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = std::rand() % 3 ? 0 : (uint16_t) std::rand();
+        a[i] = r[i] = (uint16_t) std::rand();
+      }
+      px::copy16_over(src.data() + off, a.data() + off, n);
+      for (int i = 0; i < n; ++i) if (src[off + i]) r[off + i] = src[off + i];
+      expect(a == r, "copy16_over differs from the per-pixel copy");
+    }
+  }
+}
+
+// Button "under" at {0,0,240,120}; badge "over" at {160,40,60,60}, drawn
+// later so on top. (161,41) is a corner pixel of the badge's round rect
+// (radius 8): black in the badge sprite, inside the button's fill.
+void badge(bool opaque) {
+  Panel p(5, 9, 17, 3, 3);
+  p.set_render_budget_us(0);
+  p.set_compositor(true);
+  p.setup();
+  p.add_item(new ButtonItem("under", "Under"), {0, 0, 240, 120}, 0);
+  p.add_item(new ButtonItem("over", "!"), {160, 40, 60, 60}, 0);
+  p.set_opaque("over", opaque);
+  steps(p, 4);
+
+  TFT_eSPI& tft = *TFT_eSPI::panel();
+  const uint16_t under = tft.glass(150, 41), corner = tft.glass(161, 41), inside = tft.glass(190, 45);
+  expect(under != TFT_BLACK, "button below not drawn");
+  expect(inside == under, "badge fill not drawn over the button");   // same colour: both buttons are off
+  if (opaque) expect(corner == TFT_BLACK, "opaque badge let the button through its corner");
+  else expect(corner == under, "badge corner blanked the button below");
+}
+
+}  // namespace
+
+int main() {
+  copy_over_kernel();
+  badge(false);
+  badge(true);
+  return report();
+}
@@ -0,0 +1,99 @@
+// FixedGeom.h against the float maths it replaces: sin_q15()/cos_q15() over
+// every angle against sinf()/cosf(), polar() and perp() against rounded
+// float results over the radii the items use, plus the integer helpers.
+// Then a benchmark of table lookups against sinf()/cosf() per call.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "FixedGeom.h"
+#include "harness.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+float rad(int32_t a) { return (float) a * 6.28318530718f / fx::ANGLE_FULL; }
+
+void accuracy() {
+  int sin_err = 0, cos_err = 0;
+  for (int32_t a = -fx::ANGLE_FULL; a < 2 * fx::ANGLE_FULL; ++a) {
+    sin_err = std::max(sin_err, std::abs(fx::sin_q15(a) - (int) std::lround(sinf(rad(a)) * fx::Q15_ONE)));
+    cos_err = std::max(cos_err, std::abs(fx::cos_q15(a) - (int) std::lround(cosf(rad(a)) * fx::Q15_ONE)));
+  }
+  std::printf("sin_q15 max error %d LSB, cos_q15 max error %d LSB (Q15)\n", sin_err, cos_err);
+  expect(sin_err <= 1 && cos_err <= 1, "sin/cos off by more than 1 LSB");
+
+  // Rounding a 1 LSB sine error times the radius can only move a point by
+  // one pixel where the float result sits next to .5.
+  int polar_err = 0, perp_err = 0;
+  for (int32_t a = 0; a < fx::ANGLE_FULL; ++a) {
+    for (int r = 1; r <= 240; ++r) {
+      int x, y, dx, dy;
+      fx::polar(240, 160, a, fx::q4(r), x, y);
+      fx::perp(a, fx::q4(r), dx, dy);
+      const float s = sinf(rad(a)) * r, c = cosf(rad(a)) * r;
+      polar_err = std::max({polar_err, std::abs(x - (240 + (int) std::lround(s))),
+                            std::abs(y - (160 - (int) std::lround(c)))});
+      perp_err = std::max({perp_err, std::abs(dx - (int) std::lround(c)), std::abs(dy - (int) std::lround(s))});
+    }
+  }
+  std::printf("polar max error %d px, perp max error %d px (r <= 240)\n", polar_err, perp_err);
+  expect(polar_err <= 1 && perp_err <= 1, "polar/perp off by more than 1 px");
+
+  expect(fx::turn(15, 60) == fx::ANGLE_QUARTER && fx::turn(60, 60) == fx::ANGLE_FULL, "turn()");
+  expect(fx::div_round(7, 2) == 4 && fx::div_round(-7, 2) == -4 && fx::div_round(5, 3) == 2, "div_round()");
+  expect(fx::scale_clamped(-5, 0, 10, 100) == 0 && fx::scale_clamped(15, 0, 10, 100) == 100 &&
+         fx::scale_clamped(5, 0, 10, 100) == 50, "scale_clamped()");
+}
+
+template <typename F>
+double ns_per_call(int n, F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  f(n);
+  const auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+void benchmark() {
+  constexpr int N = 4 << 20;
+  volatile int32_t sink_i = 0;
+  volatile float sink_f = 0;
+  const double fixed = ns_per_call(N, [&](int n){
+    int32_t acc = 0;
+    for (int i = 0; i < n; ++i) acc += fx::sin_q15(i * 7) + fx::cos_q15(i * 7);
+    sink_i = acc;
+  });
+  const double flt = ns_per_call(N, [&](int n){
+    float acc = 0;
+    for (int i = 0; i < n; ++i) acc += sinf(rad(i * 7)) + cosf(rad(i * 7));
+    sink_f = acc;
+  });
+  const double pol = ns_per_call(N, [&](int n){
+    int32_t acc = 0;
+    for (int i = 0; i < n; ++i) { int x, y; fx::polar(240, 160, i * 7, fx::q4(100), x, y); acc += x + y; }
+    sink_i = acc;
+  });
+  const double pol_f = ns_per_call(N, [&](int n){
+    int32_t acc = 0;
+    for (int i = 0; i < n; ++i) {
+      const float a = rad(i * 7);
+      acc += 240 + (int) lroundf(sinf(a) * 100) + 160 - (int) lroundf(cosf(a) * 100);
+    }
+    sink_i = acc;
+  });
+  (void) sink_i; (void) sink_f;
+  std::printf("sin+cos: table %.2f ns, sinf+cosf %.2f ns per pair\n", fixed, flt);
+  std::printf("polar:   table %.2f ns, float %.2f ns per point\n", pol, pol_f);
+}
+
+}  // namespace
+
+int main() {
+  accuracy();
+  benchmark();
+  return report();
+}
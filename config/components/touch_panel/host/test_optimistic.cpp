@@ -0,0 +1,69 @@
+// Optimistic toggle feedback through taps on the stand-in touch controller:
+// two buttons are clicked before either switch answers, then one switch
+// confirms and the other button times out. Each click must be accounted
+// for on its own in the perf sensors (one confirmation, one rollback), not
+// just the last one.
+#include <cstdio>
+
+#include "harness.h"
+#include "panel.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+// A short press at screen (x,y); the inverse of TouchEngine::map_() with the
+// default calibration.
+void tap(Panel& p, int x, int y) {
+  XPT2046_Touchscreen& ts = *XPT2046_Touchscreen::instance();
+  ts.set_point((int16_t)(200 + y * 3600 / 320), (int16_t)(200 + x * 3600 / 480), 600);
+  steps(p, 3);
+  ts.set_point(0, 0, 0);
+  steps(p, 3);
+}
+
+using Feedback = IPanelItem::Feedback;
+
+void two_pending_clicks() {
+  Panel p(5, 9, 17, 3, 3);
+  p.set_render_budget_us(0);
+  p.set_optimistic_timeout_ms(1000);
+  esphome::sensor::Sensor confirm, rollbacks;
+  p.set_perf_sensor(PERF_CONFIRM_LATENCY, &confirm);
+  p.set_perf_sensor(PERF_ROLLBACKS, &rollbacks);
+  p.setup();
+
+  esphome::switch_::Switch sw_a, sw_b;
+  auto* a = new ButtonItem("a", "A");
+  auto* b = new ButtonItem("b", "B");
+  p.add_item(a, {0, 0, 160, 100}, 0);
+  p.add_item(b, {200, 0, 160, 100}, 0);
+  p.bind_switch(a, &sw_a);
+  p.bind_switch(b, &sw_b);
+  steps(p, 4);
+  p.host_fire_intervals();            // start a fresh perf window
+
+  tap(p, 80, 50);
+  tap(p, 280, 50);
+  expect(a->FeedbackState() == Feedback::PENDING && b->FeedbackState() == Feedback::PENDING,
+         "taps did not leave both buttons pending");
+
+  sw_b.publish_state(true);
+  steps(p, 2);
+  expect(b->FeedbackState() == Feedback::CONFIRMED, "switch did not confirm its button");
+  steps(p, 1100 / 34);
+  expect(a->FeedbackState() == Feedback::ROLLED_BACK, "unanswered click did not roll back");
+
+  p.host_fire_intervals();
+  std::printf("confirm latency %.0f us, rollbacks %.0f\n", confirm.state, rollbacks.state);
+  expect(confirm.state > 0, "confirmation not timed");
+  expect(rollbacks.state == 1, "rollback of the earlier click not counted");
+}
+
+}  // namespace
+
+int main() {
+  two_pending_clicks();
+  return report();
+}
@@ -0,0 +1,188 @@
+// PixelKernels.h against a per-pixel scalar reference: every expand kernel
+// for every source offset and length up to 70 (so each head, body and tail
+// case of the word-wide loops is hit), fill16()/copy16() at every alignment,
+// and fill_rect() against the sprite's own fillRect(). Output must match
+// byte for byte, including the bytes just past the end. Then the kernels'
+// throughput against the scalar loops. On the ESP32-S3 build the same
+// entry points run the PIE paths (TOUCH_PANEL_PIE), which must give the
+// same bytes as the word-wide code checked here.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "PixelKernels.h"
+#include "harness.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+// Reference conversions, one pixel at a time as TFT_eSPI's drivers do it.
+uint16_t ref565(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+void ref666(uint8_t* d, uint16_t c) {
+  d[0] = (uint8_t)((c & 0xF800) >> 8);
+  d[1] = (uint8_t)((c & 0x07E0) >> 3);
+  d[2] = (uint8_t)((c & 0x001F) << 3);
+}
+int nibble(const uint8_t* img, int p) { return (p & 1) ? (img[p >> 1] & 0x0F) : (img[p >> 1] >> 4); }
+
+struct Tables {
+  uint16_t lut8[256];
+  uint32_t lut8_666[256];
+  uint16_t pal[16];
+  uint32_t lut4x2[256];
+  uint32_t lut4_666[16];
+};
+
+// As PushPipeline builds them.
+Tables make_tables() {
+  Tables t;
+  for (int c = 0; c < 256; ++c) {
+    const uint16_t v = TFT_eSPI::color8to16((uint8_t) c);
+    t.lut8[c] = px::wire565(v);
+    t.lut8_666[c] = px::wire666(v);
+  }
+  for (int i = 0; i < 16; ++i) {
+    t.pal[i] = (uint16_t) std::rand();
+    t.lut4_666[i] = px::wire666(t.pal[i]);
+  }
+  for (int b = 0; b < 256; ++b)
+    t.lut4x2[b] = px::wire565(t.pal[b >> 4]) | ((uint32_t) px::wire565(t.pal[b & 15]) << 16);
+  return t;
+}
+
+constexpr int MAX_N = 70;
+constexpr int GUARD = 8;   // bytes/pixels past the end that must stay untouched
+
+void expand_kernels(const Tables& t, const std::vector<uint8_t>& src) {
+  const uint16_t* src16 = (const uint16_t*) src.data();
+  for (int off = 0; off < 8; ++off) {
+    for (int n = 0; n <= MAX_N; ++n) {
+      std::vector<uint16_t> a(n + GUARD, 0xA5A5), r(n + GUARD, 0xA5A5);
+      std::vector<uint8_t> A(3 * n + GUARD, 0x5A), R(3 * n + GUARD, 0x5A);
+
+      px::expand8_565(&src[off], a.data(), n, t.lut8);
+      for (int i = 0; i < n; ++i) r[i] = ref565(TFT_eSPI::color8to16(src[off + i]));
+      expect(a == r, "expand8_565 (offset %d, %d px)", off, n);
+
+      px::expand8_666(&src[off], A.data(), n, t.lut8_666);
+      for (int i = 0; i < n; ++i) ref666(&R[3 * i], TFT_eSPI::color8to16(src[off + i]));
+      expect(A == R, "expand8_666 (offset %d, %d px)", off, n);
+
+      std::fill(a.begin(), a.end(), 0xA5A5); std::fill(r.begin(), r.end(), 0xA5A5);
+      px::expand4_565(src.data(), off, a.data(), n, t.lut4x2);
+      for (int i = 0; i < n; ++i) r[i] = ref565(t.pal[nibble(src.data(), off + i)]);
+      expect(a == r, "expand4_565 (offset %d, %d px)", off, n);
+
+      std::fill(A.begin(), A.end(), 0x5A); std::fill(R.begin(), R.end(), 0x5A);
+      px::expand4_666(src.data(), off, A.data(), n, t.lut4_666);
+      for (int i = 0; i < n; ++i) ref666(&R[3 * i], t.pal[nibble(src.data(), off + i)]);
+      expect(A == R, "expand4_666 (offset %d, %d px)", off, n);
+
+      std::fill(A.begin(), A.end(), 0x5A); std::fill(R.begin(), R.end(), 0x5A);
+      px::expand16_666(src16 + off, A.data(), n);
+      for (int i = 0; i < n; ++i) ref666(&R[3 * i], ref565(src16[off + i]));
+      expect(A == R, "expand16_666 (offset %d, %d px)", off, n);
+    }
+  }
+}
+
+void fill_copy(const std::vector<uint8_t>& src) {
+  // 16-byte aligned backing store; dst starts at every pixel alignment.
+  alignas(16) uint16_t a[MAX_N + 16 + GUARD], r[MAX_N + 16 + GUARD];
+  const uint16_t* src16 = (const uint16_t*) src.data();
+  for (int off = 0; off < 8; ++off) {
+    for (int n = 0; n <= MAX_N; ++n) {
+      std::fill(std::begin(a), std::end(a), 0xA5A5); std::fill(std::begin(r), std::end(r), 0xA5A5);
+      px::fill16(a + off, 0x1234, n);
+      for (int i = 0; i < n; ++i) r[off + i] = 0x1234;
+      expect(memcmp(a, r, sizeof(a)) == 0, "fill16 (offset %d, %d px)", off, n);
+
+      for (int so = 0; so < 8; ++so) {
+        std::fill(std::begin(a), std::end(a), 0xA5A5); std::fill(std::begin(r), std::end(r), 0xA5A5);
+        px::copy16(src16 + so, a + off, n);
+        for (int i = 0; i < n; ++i) r[off + i] = src16[so + i];
+        expect(memcmp(a, r, sizeof(a)) == 0, "copy16 (offset %d, %d px)", off * 8 + so, n);
+      }
+    }
+  }
+}
+
+// fill_rect() writes the buffer directly for 8/16 bit; it must leave exactly
+// what the sprite's own fillRect() would.
+void fill_rect() {
+  TFT_eSPI tft;
+  for (int depth : {4, 8, 16}) {
+    TFT_eSprite a(&tft), r(&tft);
+    a.setColorDepth(depth); r.setColorDepth(depth);
+    a.createSprite(37, 11); r.createSprite(37, 11);
+    a.fillSprite(TFT_WHITE); r.fillSprite(TFT_WHITE);
+    const int bytes = depth == 4 ? (37 * 11 + 1) / 2 : 37 * 11 * depth / 8;
+    const uint16_t color = depth == 4 ? 9 : 0x8A51;
+    const int rects[][4] = {{0, 0, 37, 11}, {3, 2, 5, 4}, {-4, -2, 9, 5}, {30, 8, 20, 20}, {1, 1, 36, 1}, {5, 5, 0, 3}};
+    for (const auto& q : rects) {
+      px::fill_rect(a, q[0], q[1], q[2], q[3], color);
+      r.fillRect(q[0], q[1], q[2], q[3], color);
+      expect(memcmp(a.getPointer(), r.getPointer(), bytes) == 0, "fill_rect vs fillRect (%d bit, %d px)", depth, q[2] * q[3]);
+    }
+  }
+}
+
+template <typename F>
+double px_per_us(int n_px, int reps, F&& f) {
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; ++i) f();
+  const auto t1 = std::chrono::steady_clock::now();
+  return (double) n_px * reps / std::max(1e-3, std::chrono::duration<double, std::micro>(t1 - t0).count());
+}
+
+void benchmark(const Tables& t, const std::vector<uint8_t>& src) {
+  static volatile int row_px = 480;   // one full-width row, opaque so the tails stay generic
+  const int N = row_px;
+  constexpr int REPS = 20000;
+  std::vector<uint8_t> out(3 * N + 16);
+  uint8_t* o = out.data();
+  const uint8_t* s = src.data();
+  const uint16_t* s16 = (const uint16_t*) src.data();
+  volatile uint8_t sink = 0;
+
+  struct Row { const char* name; double kernel, scalar; };
+  const Row rows[] = {
+    {"8 -> 565", px_per_us(N, REPS, [&]{ px::expand8_565(s, (uint16_t*) o, N, t.lut8); }),
+                 px_per_us(N, REPS, [&]{ for (int i = 0; i < N; ++i) ((uint16_t*) o)[i] = t.lut8[s[i]]; })},
+    {"8 -> 666", px_per_us(N, REPS, [&]{ px::expand8_666(s, o, N, t.lut8_666); }),
+                 px_per_us(N, REPS, [&]{
+                   for (int i = 0; i < N; ++i) { const uint32_t v = t.lut8_666[s[i]];
+                     o[3*i] = (uint8_t) v; o[3*i+1] = (uint8_t)(v >> 8); o[3*i+2] = (uint8_t)(v >> 16); } })},
+    {"4 -> 565", px_per_us(N, REPS, [&]{ px::expand4_565(s, 0, (uint16_t*) o, N, t.lut4x2); }),
+                 px_per_us(N, REPS, [&]{ for (int i = 0; i < N; ++i) ((uint16_t*) o)[i] = px::wire565(t.pal[nibble(s, i)]); })},
+    {"4 -> 666", px_per_us(N, REPS, [&]{ px::expand4_666(s, 0, o, N, t.lut4_666); }),
+                 px_per_us(N, REPS, [&]{ for (int i = 0; i < N; ++i) ref666(o + 3 * i, t.pal[nibble(s, i)]); })},
+    {"16 -> 666", px_per_us(N, REPS, [&]{ px::expand16_666(s16, o, N); }),
+                  px_per_us(N, REPS, [&]{ for (int i = 0; i < N; ++i) ref666(o + 3 * i, ref565(s16[i])); })},
+    {"fill16", px_per_us(N, REPS, [&]{ px::fill16((uint16_t*) o, 0x1234, N); }),
+               px_per_us(N, REPS, [&]{ for (int i = 0; i < N; ++i) ((volatile uint16_t*) o)[i] = 0x1234; })},
+  };
+  sink = out[7];
+  (void) sink;
+  std::printf("%-10s %12s %12s\n", "kernel", "px/us", "scalar px/us");
+  for (const Row& r : rows) std::printf("%-10s %12.1f %12.1f\n", r.name, r.kernel, r.scalar);
+}
+
+}  // namespace
+
+int main() {
+  std::srand(1);
+  const Tables t = make_tables();
+  std::vector<uint8_t> src(4096);
+  for (auto& v : src) v = (uint8_t) std::rand();
+
+  expand_kernels(t, src);
+  fill_copy(src);
+  fill_rect();
+  benchmark(t, src);
+  return report();
+}
@@ -0,0 +1,97 @@
+// Solid-area window fills (Panel::set_solid_fills()) on the host stand-ins.
+// Per sprite depth, a button is drawn as a sprite push and then with its
+// fills split off: the glass must be identical (no seams where a fill meets
+// the quantised sprite pixels), every pixel must still be clocked out, and
+// the table shows what the split costs on the bus. Then Panel::benchmark(),
+// which pushes the items of every page through their cells, must leave the
+// visible page's cached frame unchanged.
+#include <cstdio>
+#include <vector>
+
+#include "harness.h"
+#include "panel.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+std::vector<uint16_t> glass(TFT_eSPI& tft) {
+  std::vector<uint16_t> g;
+  g.reserve(480 * 320);
+  for (int y = 0; y < 320; ++y)
+    for (int x = 0; x < 480; ++x) g.push_back(tft.glass(x, y));
+  return g;
+}
+
+std::vector<uint16_t> cell(TFT_eSPI& tft, const Rect& r) {
+  std::vector<uint16_t> g;
+  for (int y = r.y; y < r.y + r.h; ++y)
+    for (int x = r.x; x < r.x + r.w; ++x) g.push_back(tft.glass(x, y));
+  return g;
+}
+
+// Button colours that are neither RGB332 nor in the 4-bit palette below
+// (TFT_DARKGREY), so an unquantised fill would show.
+void fills_match_sprite(int depth) {
+  static const uint16_t PAL[] = {TFT_WHITE, TFT_LIGHTGREY, TFT_GREEN, TFT_ORANGE, 0x6B4D};
+  Panel p(5, 9, 17, 3, 3);
+  p.set_render_budget_us(0);
+  p.setup();
+  const Rect b = {40, 30, 160, 100};
+  auto* button = new ButtonItem("button", "Fan");
+  p.add_item(button, b, 0);
+  p.set_color_depth("button", depth);
+  button->SetPalette(PAL, 5);
+  steps(p, 4);
+
+  struct { TftStats s; std::vector<uint16_t> px; } run[2];
+  for (int split = 0; split < 2; ++split) {
+    p.set_solid_fills(split);
+    p.set_color_depth("button", depth);          // full repaint
+    tft_stats().reset();
+    steps(p, 4);
+    run[split].s = tft_stats();
+    run[split].px = cell(*TFT_eSPI::panel(), b);
+  }
+  const uint64_t cell_px = (uint64_t) b.w * b.h;
+  std::printf("  %2d-bit  %9llu %9llu %9llu %9llu %10llu %9llu\n", depth,
+              (unsigned long long) run[0].s.glass_px, (unsigned long long) run[1].s.glass_px,
+              (unsigned long long) run[0].s.spi_bytes, (unsigned long long) run[1].s.spi_bytes,
+              (unsigned long long) run[0].s.windows, (unsigned long long) run[1].s.windows);
+  expect(run[0].px == run[1].px, "split fills differ from the sprite push (seam)");
+  expect(run[1].s.windows > run[0].s.windows, "nothing was split off");
+  expect(run[0].s.glass_px == cell_px && run[1].s.glass_px == cell_px, "not every pixel was clocked out once");
+  expect(run[1].s.spi_bytes >= cell_px * TFT_eSPI::WIRE_BYTES, "split sent fewer bytes than pixels");
+}
+
+// Page 1's button sits where page 0 has nothing, so only a stray split push
+// into page 0's frame can put it on the glass when page 0 is shown again.
+void benchmark_keeps_cached_frame() {
+  Panel p(5, 9, 17, 3, 3);
+  p.set_render_budget_us(0);
+  p.set_solid_fills(true);
+  p.set_page_cache_kb(1024);
+  p.setup();
+  p.add_item(new ButtonItem("b0", "Zero"), 0, 0, 1, 1, 0);
+  p.add_item(new ButtonItem("b1", "One", 1), 1, 1, 1, 1, 1);
+  steps(p, 6);
+  const std::vector<uint16_t> before = glass(*TFT_eSPI::panel());
+
+  p.benchmark(2);
+  p.next_page();
+  steps(p, 12);
+  p.prev_page();
+  steps(p, 12);
+  expect(glass(*TFT_eSPI::panel()) == before, "benchmark() changed the cached frame of the visible page");
+}
+
+}  // namespace
+
+int main() {
+  std::printf("  depth   %9s %9s %9s %9s %10s %9s\n", "sprite px", "split px", "sprite B", "split B",
+              "sprite win", "split win");
+  for (int depth : {4, 8, 16}) fills_match_sprite(depth);
+  benchmark_keeps_cached_frame();
+  return report();
+}
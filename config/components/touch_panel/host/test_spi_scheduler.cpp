@@ -0,0 +1,118 @@
+// SpiScheduler against a recording stand-in bus: the order of CS changes,
+// DMA waits and jobs for coalesced display writes, prioritised queues,
+// touch samples slotted into DMA gaps and release(), plus the queue limit
+// and the busy time/transaction counters.
+#include <cstdio>
+#include <string>
+
+#include "SpiScheduler.h"
+#include "harness.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+// Logs every bus call as one letter: W dma_wait, B begin_display,
+// E end_display; jobs append their own tag. Time moves only when told to.
+struct Port {
+  std::string log;
+  uint32_t t{0};
+  void dma_wait() { log += 'W'; }
+  void begin_display() { log += 'B'; }
+  void end_display() { log += 'E'; }
+  uint32_t now_us() { return t; }
+};
+
+using Spi = SpiScheduler<Port>;
+
+void expect_log(Port& port, const char* want, const char* what) {
+  if (port.log != want) std::printf("  %s: got \"%s\", want \"%s\"\n", what, port.log.c_str(), want);
+  expect(port.log == want, what);
+  port.log.clear();
+}
+
+void coalescing() {
+  Port port;
+  Spi spi(port);
+  for (int i = 0; i < 3; ++i) spi.display([&]{ port.log += 'd'; });
+  spi.open_display();
+  expect(spi.display_open(), "display transaction not open");
+  spi.release();
+  spi.release();
+  expect_log(port, "WBdddWE", "display writes share one CS assertion");
+  expect(!spi.display_open(), "release() left the transaction open");
+  expect(spi.take_transactions() == 1, "coalesced writes counted as several transactions");
+}
+
+void priorities() {
+  Port port;
+  Spi spi(port);
+  spi.post(Spi::PRIO_DISPLAY, [&]{ port.log += 'd'; });
+  spi.post(Spi::PRIO_COMMAND, [&]{ port.log += 'c'; });
+  spi.post(Spi::PRIO_TOUCH, [&]{ port.log += 't'; });
+  spi.post(Spi::PRIO_COMMAND, [&]{ port.log += 'C'; });
+  spi.run();
+  spi.release();
+  expect_log(port, "tWBcCdWE", "touch first, then commands and display in one transaction");
+  expect(spi.take_transactions() == 2, "transaction count");
+
+  // A touch job queued while the display holds the bus closes it first.
+  spi.display([&]{ port.log += 'd'; });
+  spi.post(Spi::PRIO_TOUCH, [&]{ port.log += 't'; });
+  spi.run();
+  spi.release();
+  expect_log(port, "WBdWEt", "touch job waits for DMA and closes the display transaction");
+}
+
+void gaps() {
+  Port port;
+  Spi spi(port);
+  spi.open_display();
+  spi.gap();
+  expect_log(port, "WB", "gap() with no touch job touches the bus");
+
+  spi.post(Spi::PRIO_TOUCH, [&]{ port.log += 't'; });
+  spi.post(Spi::PRIO_TOUCH, [&]{ port.log += 'T'; });
+  spi.gap();
+  expect(spi.display_open(), "gap() did not resume the display transaction");
+  spi.release();
+  expect_log(port, "WEtTWBWE", "touch samples run between DMA bursts");
+
+  spi.post(Spi::PRIO_TOUCH, [&]{ port.log += 't'; });
+  spi.gap();
+  expect_log(port, "t", "gap() outside a display transaction opened one");
+  expect(!spi.display_open(), "gap() left a transaction open");
+}
+
+void limits_and_counters() {
+  Port port;
+  Spi spi(port);
+  int ran = 0;
+  for (int i = 0; i < Spi::QUEUE_LEN; ++i) expect(spi.post(Spi::PRIO_COMMAND, [&]{ ++ran; }), "post() refused a free slot");
+  expect(!spi.post(Spi::PRIO_COMMAND, [&]{ ++ran; }), "post() accepted a job into a full queue");
+  expect(spi.post(Spi::PRIO_TOUCH, [&]{ port.t += 5; }), "queues are not per priority");
+  spi.run();
+  expect(ran == Spi::QUEUE_LEN, "queued jobs lost");
+  expect(spi.post(Spi::PRIO_COMMAND, [&]{ ++ran; }), "queue not emptied by run()");
+  spi.run();
+  expect(ran == Spi::QUEUE_LEN + 1, "ring buffer wrap lost a job");
+
+  port.t += 100;                          // display open since t = 5
+  expect(spi.take_busy_us() == 5 + 100, "busy time of the open transaction");
+  port.t += 20;
+  spi.release();
+  expect(spi.take_busy_us() == 20, "busy time after release()");
+  expect(spi.take_busy_us() == 0, "busy time not reset");
+  expect(spi.take_transactions() == 2, "one touch and one display transaction");
+}
+
+}  // namespace
+
+int main() {
+  coalescing();
+  priorities();
+  gaps();
+  limits_and_counters();
+  return report();
+}
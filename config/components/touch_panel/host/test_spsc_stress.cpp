@@ -0,0 +1,119 @@
+// Cross-thread stress: SpscQueue ordering between two threads, then a
+// threaded Panel with both of its command sources busy at once. The ESPHome
+// loop (main thread) posts a numbered time broadcast per iteration while a
+// touch thread swipes pages, which the render task turns into page steps.
+// Every broadcast must reach the items in order, none twice, and every swipe
+// must flip the page. Build with -DTOUCH_PANEL_HOST_TSAN=ON to have
+// ThreadSanitizer check the same run.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "harness.h"
+#include "panel.h"
+
+using namespace touch_panel;
+using namespace host_test;
+
+namespace {
+
+void sleep_ms(int ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+void queue_order() {
+  SpscQueue<PanelCommand, 64> q;
+  constexpr int N = 500000;
+  std::atomic<bool> ok{true};
+  std::thread consumer([&]{
+    PanelCommand c;
+    for (int want = 0; want < N; ) {
+      if (!q.pop(c)) { std::this_thread::yield(); continue; }
+      if (c.a != want || c.b != want * 3) ok = false;
+      ++want;
+    }
+  });
+  for (int i = 0; i < N; ++i) {
+    const PanelCommand c{PanelCommand::TIME, nullptr, i, i * 3};
+    while (!q.push(c)) std::this_thread::yield();
+  }
+  consumer.join();
+  expect(ok && q.empty(), "SpscQueue lost or reordered entries");
+}
+
+// Records the time broadcasts it gets as one running number.
+class SeqItem : public BaseItem {
+public:
+  using BaseItem::BaseItem;
+  TopicMask Topics() const override { return topic_bit(TOPIC_TIME); }
+  void OnTimeUpdate(int h, int m, int s) override { seen.push_back(h * 3600 + m * 60 + s); }
+  bool RenderIfDirty(TFT_eSPI&, TFT_eSprite&) override { return true; }
+  std::vector<int> seen;
+};
+
+// A horizontal drag across most of the screen in ~100 ms. Raw y runs along
+// the 480 px axis (see TouchEngine::map_()).
+void swipe(XPT2046_Touchscreen& ts, bool left) {
+  const int from = left ? 3400 : 600, to = left ? 600 : 3400;
+  for (int i = 0; i <= 10; ++i) {
+    ts.set_point(2000, (int16_t)(from + (to - from) * i / 10), 600);
+    sleep_ms(10);
+  }
+  ts.set_point(0, 0, 0);
+  sleep_ms(40);
+}
+
+void panel_producers() {
+  SeqItem page0("seq0", 0), page1("seq1", 1);
+  constexpr int SWIPES = 12;
+  int sent = 0, flips = 0;
+  {
+    Panel p(5, 9, 17, 3, 3);
+    p.setup();
+    p.add_item(&page0, {0, 0, 480, 320}, 0, false);
+    p.add_item(&page1, {0, 0, 480, 320}, 1, false);
+    p.set_render_task(true);
+    p.loop();                        // starts the render task
+
+    std::atomic<bool> touching{true};
+    std::thread touch([&]{
+      XPT2046_Touchscreen& ts = *XPT2046_Touchscreen::instance();
+      for (int i = 0; i < SWIPES; ++i) {
+        const int before = p.page();
+        swipe(ts, i % 2 == 0);
+        for (int w = 0; w < 50 && p.page() == before; ++w) sleep_ms(2);
+        if (p.page() != before) ++flips;
+      }
+      touching = false;
+    });
+
+    while (touching) {
+      ++sent;
+      p.set_time(sent / 3600, sent / 60 % 60, sent % 60);
+      p.loop();
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    touch.join();
+    sleep_ms(50);                    // let the render task drain cmds_
+  }                                  // joins the render task
+
+  expect(flips == SWIPES, "a swipe did not flip the page");
+  int got = 0;
+  for (const SeqItem* it : {&page0, &page1}) {
+    for (size_t i = 1; i < it->seen.size(); ++i)
+      if (it->seen[i] <= it->seen[i - 1]) { expect(false, "time broadcast replayed or reordered"); break; }
+    if (!it->seen.empty()) expect(it->seen.back() <= sent, "time broadcast never sent");
+    got += (int) it->seen.size();
+  }
+  expect(got > 0, "no time broadcast arrived");
+  std::printf("panel: %d broadcasts sent, %d delivered, %d/%d swipes flipped the page\n",
+              sent, got, flips, SWIPES);
+}
+
+}  // namespace
+
+int main() {
+  queue_order();
+  panel_producers();
+  return report();
+}
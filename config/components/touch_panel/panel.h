@@ -6,12 +6,29 @@
 #include <algorithm>
 #include <mutex>
 #include <atomic>
+#include <memory>
 
 #include "PanelItem.h"
 #include "LightItem.h"
 #include "ButtonItem.h"
 #include "EnvItem.h"
 #include "ClockItem.h"
+#include "ListItem.h"
+#include "ChartItem.h"
+#include "GaugeItem.h"
+#include "PushPipeline.h"
+#include "SpiScheduler.h"
+#include "PageCache.h"
+#include "TileMap.h"
+#include "DrawList.h"
+#include "Binding.h"
+#include "EventBus.h"
+#include "Animation.h"
+#include "ItemStore.h"
+#include "TouchEngine.h"
+#include "RenderTask.h"
+#include "SpscQueue.h"
+#include "PerfStats.h"
 
 #include "esphome.h"
 #include <TFT_eSPI.h>
@@ -22,20 +39,25 @@ namespace touch_panel {
 #ifndef panel_h
 #define panel_h
 
+static const char *const TAG = "touch_panel";
+
 // ---------- Panel (grid + pages + routing) ----------
 class Panel : public esphome::Component {
 public:
   Panel(int tft_cs, int touch_cs, int touch_irq, int cols=3, int rows=3)
   : tft_cs_(tft_cs), touch_cs_(touch_cs), touch_irq_(touch_irq),
-    ts_(touch_cs_, touch_irq_), cols_(cols), rows_(rows), scratch_(&tft_) {}
+    ts_(touch_cs_, touch_irq_), cols_(cols), rows_(rows),
+    scratch_{Scratch(&tft_), Scratch(&tft_), Scratch(&tft_)}, pusher_(tft_) {
+    pusher_.set_gap([this](){ touch_gap_(); });
+  }
 
   ~Panel() {
+    task_.stop();
     // Free items we own
-    for (auto* it : items_) delete it;
-    items_.clear();
-    last_bounds_.clear();
-    // Free the sprite buffer
-    scratch_.deleteSprite();
+    store_.clear();
+    // Free the sprite buffers
+    for (auto& s : scratch_) s.spr.deleteSprite();
+    if (compose_) { compose_->deleteSprite(); delete compose_; }
   }
 
   void setup() override {
@@ -63,71 +85,75 @@ public:
     screen_ = {0,0,480,320};
     grid_   = screen_;
     compute_grid_();
+    page_cache_.set_size(screen_.w, screen_.h);
+    tiles_.set_size(screen_.w, screen_.h);
 
     digitalWrite(touch_cs_, HIGH);
     tft_.fillScreen(TFT_BLACK);
 
-    // Prepare shared scratch sprite (lazy sized on first use)
-    scratch_.setColorDepth(8);
-    scratch_w_ = scratch_h_ = 0;
+    if (pusher_.begin()) ESP_LOGI(TAG, "DMA push pipeline active");
+
+#ifdef TOUCH_PANEL_PERF
+    perf_last_ms_ = millis();
+    set_interval("perf", perf_interval_ms_, [this](){ publish_perf_(); });
+#endif
   }
 
   void loop() override {
-    power_step_();
-
-    if (pwr_ != AWAKE) {
-      return;
+    // Started here rather than in setup() so on_boot lambdas have finished
+    // adding items before the render task starts walking them.
+    if (threaded_ && !task_.running() && !task_.start([this](){ return render_step_(); }, render_core_)) {
+      ESP_LOGE(TAG, "could not create the render task, rendering from loop()");
+      threaded_ = false;
     }
-
-    uint32_t now = millis();
-    for (auto* it : items_) if (it->Page()==current_page_) it->Tick(now);
-
-    int16_t x,y;
-    if (read_touch_(x,y)) handle_touch_(x,y);
-
-    // Reuse the shared sprite for all items on the page.
-    for (auto* it : items_) {
-      if (it->Page()!=current_page_) continue;
-      if (!it->ClearDirty()) continue;
-
-      // Ensure sprite is at least the item's size; only grow (rare).
-      const auto& b = last_bounds_[it];
-      ensure_scratch_(b.w, b.h);
-
-      // Clear the scratch area once per item before it draws.
-      scratch_.fillSprite(TFT_BLACK);
-
-      // Let the item render into the shared sprite and push.
-      it->RenderIfDirty(tft_, scratch_);
-
-      // Ensure touch is not selected while we talk to TFT
-      //digitalWrite(touch_cs_, HIGH);
-      digitalWrite(touch_cs_, HIGH);
-      //std::lock_guard<std::mutex> lk(spi_mtx_);
-      tft_tx([&](){
-        scratch_.pushSprite(b.x, b.y, 0, 0, b.w, b.h);
-      });
+    if (threaded_) {
+      run_main_callbacks_();
+      return;
     }
+    render_step_();
+  }
 
-    if (items_.empty()) {
-      if ((int32_t)(now - deadline_) >= 0) {
-        deadline_ = now + 100;
-        //std::lock_guard<std::mutex> lk(spi_mtx_);
-        tft_tx([&](){
-          tft_.setTextColor(tft_.color565(random(256), random(256), random(256)), TFT_BLACK);
-          tft_.drawString("Hello!", 10, 10, 4);
-        });
-      }
-    }
+  // ---------- Entity bindings ----------
+  // Items follow an entity directly (`items:` ... switch_id / light_id /
+  // temperature_id + humidity_id). Callbacks only record the latest value;
+  // it is applied once per render step.
+#ifdef USE_SWITCH
+  void bind_switch(ToggleItem* item, esphome::switch_::Switch* sw) {
+    item->SetOptimistic(optimistic_ms_);
+    Binding* b = add_binding_(new Binding(item));
+    sw->add_on_state_callback([this, b](bool on){ changed_(b->set_state(on)); });
+  }
+#endif
+#ifdef USE_LIGHT
+  void bind_light(ToggleItem* item, esphome::light::LightState* light) {
+    item->SetOptimistic(optimistic_ms_);
+    Binding* b = add_binding_(new Binding(item));
+    light->add_new_remote_values_callback([this, b, light](){
+      changed_(b->set_state(light->remote_values.is_on()));
+    });
   }
+#endif
+#ifdef USE_SENSOR
+  void bind_env(EnvItem* item, esphome::sensor::Sensor* temperature, esphome::sensor::Sensor* humidity) {
+    Binding* b = add_binding_(new Binding(item));
+    temperature->add_on_state_callback([this, b](float t){ changed_(b->set_temperature(t)); });
+    humidity->add_on_state_callback([this, b](float h){ changed_(b->set_humidity(h)); });
+  }
+  void bind_chart(ChartItem* item, esphome::sensor::Sensor* source) {
+    Binding* b = add_binding_(new Binding(item));
+    source->add_on_state_callback([this, b](float v){ changed_(b->set_sample(v)); });
+  }
+  void bind_gauge(GaugeItem* item, esphome::sensor::Sensor* source) {
+    Binding* b = add_binding_(new Binding(item));
+    source->add_on_state_callback([this, b](float v){ changed_(b->set_sample(v)); });
+  }
+#endif
 
+  // Prefer a binding; this posts one command per call.
   void set_button_state(const char* id, bool on) {
-    for (auto* it : items_) {
-      if (strcmp(it->Id(), id)==0) {
-        auto btn = static_cast<ButtonItem*>(it);
-        btn->SetState(on);
-      }
-    }
+    store_.for_id(id, [&](IPanelItem* it){
+      post_({PanelCommand::ITEM_STATE, it, on});
+    });
   }
 
   void add_button(const char* id, const char* label, int col, int row,
@@ -141,12 +167,22 @@ public:
   }
 
   // ---------- Public API to manage items / pages ----------
+  // Items must be added before the first loop() (e.g. from on_boot) when
+  // the render task is enabled.
   void add_item(IPanelItem* item, int col, int row, int colspan=1, int rowspan=1, int page=0) {
-    Rect cell = cell_rect_(col,row,colspan,rowspan);
-    item->SetBounds(cell);
+    add_item(item, cell_rect_(col,row,colspan,rowspan), page);
+  }
+
+  // Bounds already resolved, e.g. by the `items:` code generation, which also
+  // allocates its items statically (owned = false).
+  void add_item(IPanelItem* item, const Rect& bounds, int page, bool owned=true) {
+    if (task_.running()) ESP_LOGW(TAG, "add_item('%s') after the render task started", item->Id());
+    item->SetBounds(bounds);
     item->SetPage(page);
-    items_.push_back(item);
-    last_bounds_[item] = cell;
+    store_.add(item, bounds, page, owned);
+    bus_.subscribe(item, page);
+    page_cache_.drop(page);
+    prepared_ = false;   // Prepare() the late item on the next step
   }
 
   void add_paging_buttons(std::pair<int,int> prev_cell, std::pair<int,int> next_cell, int page=0) {
@@ -158,54 +194,212 @@ public:
     set_item_click("page_next", [this](){ next_page(); });
   }
 
+  // fn always runs on the ESPHome loop, even when clicks are detected on the
+  // render task.
   void set_item_click(const char* id, std::function<void()> fn) {
-    for (auto* it : items_)
-      if (strcmp(it->Id(), id)==0)
-        it->SetOnClick(std::move(fn));
+    click_fns_.emplace_back(new std::function<void()>(std::move(fn)));
+    MainCallback h = click_fns_.back().get();
+    store_.for_id(id, [&](IPanelItem* it){ it->SetOnClick([this, h](){ on_main_(h); }); });
   }
 
   void set_time(int hours, int minutes, int seconds) {
-    for (auto* it : items_) it->OnTimeUpdate(hours, minutes, seconds);
+    post_({PanelCommand::TIME, nullptr, hours, minutes, seconds});
   }
 
   void set_env(float t, float h) {
-    for (auto* it : items_) it->OnEnvUpdate(t, h); 
+    post_({PanelCommand::ENV, nullptr, 0, 0, 0, t, h});
   }
 
-  void next_page(){ set_page_(current_page_+1); }
-  void prev_page(){ set_page_(current_page_==0 ? max_page_() : current_page_-1); }
+  void next_page(){ post_({PanelCommand::PAGE_STEP, nullptr, +1}); }
+  void prev_page(){ post_({PanelCommand::PAGE_STEP, nullptr, -1}); }
   int  page() const { return current_page_; }
 
   void ready()
   {
-    pwr_ = AWAKE;
-    requestSleep_ = false;
+    post_({PanelCommand::READY});
   }
 
   void request_sleep(bool on)
   {
-    requestSleep_ = on;
+    post_({PanelCommand::SLEEP, nullptr, on});
+  }
+
+  // Renders every item `iterations` times and logs per-item render/push time
+  // and bytes on the wire, then the cost of a full page and of a wake-up
+  // redraw. Blocks the render step while it runs; meant to be triggered by
+  // hand (button, API service) to compare rendering changes.
+  void benchmark(int iterations = 10) {
+    post_({PanelCommand::BENCH, nullptr, std::max(1, iterations)});
   }
 
+#ifdef TOUCH_PANEL_PERF
+  void set_perf_sensor(PerfMetric m, esphome::sensor::Sensor* s) { perf_sensors_[m] = s; }
+  void set_perf_interval(uint32_t ms) { perf_interval_ms_ = ms; }
+#endif
+
+  // Run rendering, touch and power handling on a task pinned to `core`.
+  void set_render_task(bool on, int core = 0) { threaded_ = on; render_core_ = core; }
+
+  // Colour depth (4, 8 or 16) of the sprite an item renders into, trading
+  // RAM and push cost against colour fidelity. Set before the first frame.
+  void set_color_depth(const char* id, int depth) {
+    if (task_.running()) ESP_LOGW(TAG, "set_color_depth('%s') after the render task started", id);
+    store_.for_id(id, [&](IPanelItem* it){
+      it->SetColorDepth(depth);
+      // Only items that draw through Ink() take 4 bit; the rest clamp.
+      if (it->ColorDepth() != depth) ESP_LOGW(TAG, "'%s' draws at %d bit, not %d", id, it->ColorDepth(), depth);
+    });
+    prepared_ = false;   // text atlases are per depth
+  }
+  void set_calibration(int x_min, int x_max, int y_min, int y_max) {
+    touch_.set_calibration(x_min, x_max, y_min, y_max);
+  }
+  // PSRAM for composed page frames (480x320x2 bytes each); 0 disables the cache.
+  void set_page_cache_kb(uint32_t kb) { page_cache_.set_limit(kb * 1024); }
+  // Max time per loop() spent rendering; 0 renders every dirty item at once.
+  void set_render_budget_us(uint32_t us) { render_budget_us_ = us; }
+  // Target rate for Tick() and rendering; 0 renders on every loop.
+  void set_frame_rate(uint32_t fps) { pacer_.set_fps(fps); }
+  // Duration of the wipe to a cached page on next/prev; 0 switches at once.
+  // At most 65535 ms (Tween durations are 16 bit).
+  void set_page_transition_ms(uint32_t ms) { transition_ms_ = (uint16_t) std::min<uint32_t>(ms, UINT16_MAX); }
+  // Horizontal swipes not consumed by an item flip pages.
+  void set_swipe_pages(bool on) { swipe_pages_ = on; }
+  // Composite overlapping items per screen tile instead of pushing each item
+  // on its own (see composite_page_()). Black is the transparent key: later
+  // items cover earlier ones only where they drew something other than black,
+  // so a round badge leaves the corners of its cell alone. Needs a
+  // screen-sized frame in PSRAM, the page cache's if it is enabled.
+  void set_compositor(bool on) { compositor_ = on; }
+  // Compositor: copy the item's whole cell, black included (e.g. a popup
+  // that must hide what is below it).
+  void set_opaque(const char* id, bool on) {
+    store_.for_id(id, [&](IPanelItem* it){ it->SetOpaque(on); });
+  }
+  // Send the solid areas of items with a draw list as controller window
+  // fills and push only the rest from the sprite (see push_split_()). Fills
+  // keep the CPU on the bus instead of DMA, so this pays off for large flat cells.
+  void set_solid_fills(bool on) { solid_fills_ = on; }
+  // How long a clicked toggle shows its new state as pending before rolling
+  // back if the bound entity does not follow; 0 waits for the entity, as
+  // before. Applies to items bound after the call.
+  void set_optimistic_timeout_ms(uint32_t ms) { optimistic_ms_ = ms; }
+
+  // Pixels pushed over SPI by the most recent frame that drew anything.
+  uint32_t last_frame_pixels() const { return last_frame_px_; }
+  uint64_t total_pixels() const { return total_px_; }
+
 private:
-  std::mutex spi_mtx_;
   // ---------- Hardware ----------
   int tft_cs_, touch_cs_, touch_irq_;
   TFT_eSPI tft_;
   XPT2046_Touchscreen ts_;
 
-  // Shared scratch sprite
-  TFT_eSprite scratch_;
-  int scratch_w_{0}, scratch_h_{0};
+  // The shared SPI bus as SpiScheduler sees it.
+  struct BusPort {
+    Panel& p;
+    void dma_wait() { p.pusher_.wait(); }
+    void begin_display() {
+      digitalWrite(p.touch_cs_, HIGH);   // touch must not be selected while we talk to TFT
+      p.tft_.startWrite();
+    }
+    void end_display() { p.tft_.endWrite(); }
+    uint32_t now_us() { return p.perf_.now(); }   // 0 without TOUCH_PANEL_PERF
+  };
+  using Spi = SpiScheduler<BusPort>;
+  BusPort bus_port_{*this};
+  Spi spi_{bus_port_};
+  bool touch_queued_{false};            // a touch sample is waiting on the bus
+
+  // Scratch sprites shared by all items of one colour depth (4, 8, 16 bit);
+  // each is created on first use and grown to the largest such item.
+  struct Scratch {
+    TFT_eSprite spr;
+    int w{0}, h{0};
+    explicit Scratch(TFT_eSPI* tft) : spr(tft) {}
+  };
+  Scratch scratch_[3];
+  bool prepared_{false};                 // items' Prepare() has run
+  PushPipeline pusher_;
+  PageCache page_cache_{tft_};
+  TFT_eSprite* cached_{nullptr};         // frame of the page being rendered, if cached
+  bool compositor_{false};
+  TileMap tiles_;
+  TFT_eSprite* compose_{nullptr};        // compositor frame when the page cache is off
+  bool compose_all_{false};              // recomposite the whole screen next frame
+  bool solid_fills_{false};
+  SolidSplit split_;
+  uint32_t last_frame_px_{0};
+  uint64_t total_px_{0};
+
+  // ---------- Frame budget ----------
+  uint32_t render_budget_us_{8000};
+  FramePacer pacer_{30};
+  size_t render_cursor_{0};              // where the next loop resumes on the page
+  IPanelItem* render_first_{nullptr};    // last touched item, rendered before the rest
+
+  // ---------- Optimistic feedback ----------
+  // The last click that left an item pending, for the latency metrics.
+  struct PendingClick {
+    IPanelItem* item{nullptr};
+    uint32_t t_us{0};              // touch read that produced the click
+    bool drawn{false};             // rendered in the frame being pushed
+    bool shown{false};             // feedback latency taken
+  };
+  PendingClick click_;
+  // Earlier clicks on other items still waiting for their entity; each item
+  // has at most one, so the oldest only drops out with this many waiting.
+  static constexpr int MAX_EARLIER_CLICKS = 4;
+  PendingClick earlier_[MAX_EARLIER_CLICKS];
+  uint32_t optimistic_ms_{3000};
+
+  // ---------- Page transition ----------
+  // The new page's cached frame is revealed column by column from the side
+  // it comes in from; each frame pushes only the columns uncovered since the
+  // last one, so the whole wipe costs one screen of SPI traffic at any rate.
+  struct Wipe {
+    TFT_eSprite* frame{nullptr};   // nullptr: no transition running
+    int dir{0};                    // +1 next page (from the right), -1 previous
+    int shown{0};                  // columns pushed so far
+    Tween edge{0, anim::ease_in_out};
+  };
+  Wipe wipe_;
+  uint16_t transition_ms_{0};
 
   // ---------- Layout ----------
   Rect screen_{}, grid_{};
   int cols_{3}, rows_{2};
   std::vector<Rect> cell_cache_;
-  std::vector<IPanelItem*> items_;
-  std::unordered_map<IPanelItem*,Rect> last_bounds_;
+  ItemStore store_;
+  EventBus bus_;   // time/env broadcasts, render step only
+
+  std::atomic<int> current_page_{0};
+
+  // ---------- Render task ----------
+  bool threaded_{false};
+  int render_core_{0};
+  RenderTask task_;
+  SpscQueue<PanelCommand, 64> cmds_;        // ESPHome loop -> render step
+  // Render step -> ESPHome loop, stamped with the touch read that caused it.
+  struct MainCall { MainCallback fn; uint32_t t_us; };
+  SpscQueue<MainCall, 16> main_q_;
+  std::vector<std::unique_ptr<std::function<void()>>> click_fns_;
+  std::vector<std::unique_ptr<Binding>> bindings_;
+  std::atomic<bool> bindings_changed_{false};
+
+  Binding* add_binding_(Binding* b) {
+    bindings_.emplace_back(b);
+    return b;
+  }
+  void changed_(bool changed) {
+    if (changed) bindings_changed_.store(true, std::memory_order_release);
+  }
 
-  int current_page_{0};
+  // ---------- Touch ----------
+  TouchEngine touch_;
+  IPanelItem* touch_target_{nullptr};   // item the current touch started on
+  uint32_t touch_read_us_{0};           // when the controller was last read (perf)
+  bool swipe_pages_{true};
   
   enum PwrState { NOINIT, AWAKE, GOING_OFF_DISPOFF, GOING_OFF_SLEEPIN_WAIT, SLEEPING,
                 WAKING_SLEEPOUT_WAIT, WAKING_DISPON, WAKING_SETTLE_WAIT };
@@ -214,33 +408,18 @@ private:
 
   std::atomic<bool> requestSleep_{false};
 
-  inline void tft_tx(std::function<void()> fn) {
-    std::lock_guard<std::mutex> lk(spi_mtx_);
-  #ifdef TFT_eSPI_ENABLE_DMA
-    tft_.dmaWait();                  // finish any prior DMA first
-  #endif
-    tft_.startWrite();
-    fn();                            // do the SPI writes
-    tft_.endWrite();
-  }
-
-  inline bool touch_read(TS_Point &p) {
-    std::lock_guard<std::mutex> lk(spi_mtx_);
-  #ifdef TFT_eSPI_ENABLE_DMA
-    tft_.dmaWait();                  // make sure TFT is idle before reading touch
-  #endif
-    p = ts_.getPoint();              // XPT2046 lib handles its own CS
-    return true;
-  }
+  // Display writes share the transaction the step already holds, if any.
+  inline void tft_tx(const std::function<void()>& fn) { spi_.display(fn); }
 
+  // One bus transaction for all pushes of a frame, so DMA can keep CS low
+  // while the CPU renders the next item. It stays open past the frame until
+  // a touch sample needs the bus or the step ends (see render_step_()).
+  void frame_begin_() { spi_.open_display(); }
+  void frame_end_() { pusher_.wait(); }
+
+  // Queued; runs with the step's next spi_.run(), ahead of the frame.
   inline void lcd_cmd(uint8_t c) {
-    std::lock_guard<std::mutex> lk(spi_mtx_);
-    #ifdef TFT_eSPI_ENABLE_DMA
-    tft_.dmaWait();
-    #endif
-    tft_.startWrite();
-    tft_.writecommand(c);
-    tft_.endWrite();
+    spi_.post(Spi::PRIO_COMMAND, [this, c](){ tft_.writecommand(c); });
   }
 
   const char* pwr_to_str(PwrState s) {
@@ -296,14 +475,435 @@ private:
           break;
 
         case WAKING_SETTLE_WAIT:
-          tft_tx([&](){ tft_.fillScreen(TFT_BLACK); });
-          invalidate_visible_page_();
+          show_page_(true);
           pwr_ = AWAKE;
           break;
       }
     }
   }
 
+  // ---------- Cross-thread plumbing ----------
+  bool async_() const { return threaded_ && task_.running(); }
+
+  // Applies c now, or queues it for the render task once that is running.
+  void post_(const PanelCommand& c) {
+    if (!async_()) { apply_(c); return; }
+    if (!cmds_.push(c)) ESP_LOGW(TAG, "command queue full, dropped type %d", (int) c.type);
+  }
+
+  void apply_commands_() {
+    PanelCommand c;
+    while (cmds_.pop(c)) apply_(c);
+  }
+
+  void apply_(const PanelCommand& c) {
+    switch (c.type) {
+      case PanelCommand::TIME:
+        bus_.publish_time(c.a, c.b, c.c, current_page_);
+        break;
+      case PanelCommand::ENV:
+        bus_.publish_env(c.f0, c.f1, current_page_);
+        break;
+      case PanelCommand::ITEM_STATE:
+        c.item->SetState(c.a != 0);
+        break;
+      case PanelCommand::SLEEP:
+        requestSleep_ = c.a != 0;
+        break;
+      case PanelCommand::READY:
+        pwr_ = AWAKE;
+        requestSleep_ = false;
+        break;
+      case PanelCommand::PAGE_STEP:
+        step_page_(c.a > 0 ? +1 : -1);
+        break;
+      case PanelCommand::BENCH:
+        run_benchmark_(c.a);
+        break;
+    }
+  }
+
+  void on_main_(MainCallback h) {
+    if (!async_()) { run_main_({h, touch_read_us_}); return; }
+    if (!main_q_.push({h, touch_read_us_})) ESP_LOGW(TAG, "click queue full, dropped a click");
+  }
+
+  void run_main_callbacks_() {
+    MainCall c;
+    while (main_q_.pop(c)) run_main_(c);
+  }
+
+  void run_main_(const MainCall& c) {
+    perf_.set_touch_latency(perf_.now() - c.t_us);
+    (*c.fn)();
+  }
+
+  // ---------- Rendering ----------
+  // One pass of the display state machine: commands, power, touch, render.
+  // Runs on the ESPHome loop, or on the render task when that is enabled.
+  // Returns true if the panel is awake.
+  bool render_step_() {
+    const uint32_t t0 = perf_.now();
+    const bool awake = render_pass_();
+    spi_.release();                  // never hold the bus between steps
+    perf_.add_spi(spi_.take_busy_us(), spi_.take_transactions());
+    if (awake) perf_.add_loop(perf_.now() - t0);
+    return awake;
+  }
+
+  bool render_pass_() {
+    apply_commands_();
+    if (bindings_changed_.exchange(false, std::memory_order_acquire))
+      for (auto& b : bindings_) b->apply();
+    settle_click_();
+    power_step_();
+    spi_.run();
+
+    if (pwr_ != AWAKE) {
+      return false;
+    }
+
+    if (!prepared_) {
+      for (auto& s : store_.all())
+        s.item->Prepare(tft_, scratch_for_(s.item, s.bounds.w, s.bounds.h));
+      prepared_ = true;
+    }
+
+    uint32_t now = millis();
+    poll_touch_(now);
+    spi_.run();
+    dispatch_touch_();
+
+    // Touch feedback does not wait for the next frame slot (unless a page
+    // transition is running, which renders no items anyway).
+    if ((render_first_ && !wipe_.frame) || pacer_.due(now)) {
+      for (auto& s : store_.page(current_page_)) s.item->Tick(now);
+      if (!wipe_step_(now)) render_page_();
+      settle_click_();               // Tick() may have rolled it back
+    }
+    perf_.add_dropped(pacer_.take_dropped());
+
+    if (store_.empty()) {
+      if ((int32_t)(now - deadline_) >= 0) {
+        deadline_ = now + 100;
+        tft_tx([&](){
+          tft_.setTextColor(tft_.color565(random(256), random(256), random(256)), TFT_BLACK);
+          tft_.drawString("Hello!", 10, 10, 4);
+        });
+      }
+    }
+    return true;
+  }
+
+  // Renders dirty items of the visible page until the budget is used up; the
+  // rest stay dirty and the next loop resumes after the last item drawn. The
+  // last touched item goes first so feedback is never queued behind a page.
+  void render_page_(){
+    // A frame starts out black with every item dirty, so it is complete once
+    // they have all rendered; from then on each push also lands in it.
+    cached_ = page_cache_.find(current_page_);
+    if (!cached_ && page_cache_.enabled() && !store_.page(current_page_).empty()) {
+      cached_ = page_cache_.create(current_page_);
+      if (cached_) invalidate_visible_page_();
+    }
+    if (compositor_ && composite_page_()) return;
+
+    auto page = store_.page(current_page_);
+    const size_t n = page.end() - page.begin();
+    const uint32_t start = micros();
+    uint32_t frame_px = 0;
+    bool over = false;
+
+    if (render_first_ && render_first_->Page() == current_page_) {
+      for (auto& s : page)
+        if (s.item == render_first_) { render_item_(s, frame_px); break; }
+    }
+    render_first_ = nullptr;
+
+    if (render_cursor_ >= n) render_cursor_ = 0;
+    for (size_t k = 0; k < n && !over; ++k) {
+      const size_t i = (render_cursor_ + k) % n;
+      if (!render_item_(page.begin()[i], frame_px)) continue;
+      over = render_budget_us_ && (micros() - start) >= render_budget_us_;
+      if (over) render_cursor_ = (i + 1) % n;
+    }
+    frame_end_();
+    frame_done_(frame_px, start, over);
+  }
+
+  void frame_done_(uint32_t frame_px, uint32_t start, bool over){
+    perf_.add_dma_wait(pusher_.take_wait_us());
+    if (frame_px) {
+      perf_.add_frame(frame_px);
+      last_frame_px_ = frame_px;
+      total_px_ += frame_px;
+      if (click_.drawn) {
+        perf_.set_feedback_latency(perf_.now() - click_.t_us);
+        click_.drawn = false;
+        click_.shown = true;
+      }
+      ESP_LOGV(TAG, "frame pushed %u px in %u us%s", (unsigned) frame_px,
+               (unsigned)(micros() - start), over ? " (budget hit)" : "");
+    }
+  }
+
+  // Compositor mode. Damage of all items is collected per screen tile; each
+  // item over a damaged tile is then drawn, bottom to top (store order, as
+  // hit_item_() sees it), into a screen frame, and the damaged tiles are
+  // pushed from the frame. Overlapping items no longer overwrite each other
+  // on the glass, and each damaged pixel goes over SPI once per frame. The
+  // render budget does not apply: a frame is composited as a whole.
+  // Returns false if there is no frame to composite into.
+  bool composite_page_(){
+    TFT_eSprite* frame = cached_ ? cached_ : compose_frame_();
+    if (!frame) return false;
+    auto page = store_.page(current_page_);
+    tiles_.clear();
+    if (compose_all_) { tiles_.mark_all(); compose_all_ = false; }
+    for (auto& s : page) {
+      if (!s.item->ClearDirty()) continue;
+      Rect dmg[MAX_DAMAGE_RECTS];
+      const int n = s.item->TakeDamage(dmg, MAX_DAMAGE_RECTS);
+      if (n == 0) tiles_.mark(s.bounds);
+      for (int i=0;i<n;++i) tiles_.mark({s.bounds.x + dmg[i].x, s.bounds.y + dmg[i].y, dmg[i].w, dmg[i].h});
+    }
+    render_first_ = nullptr;
+    if (!tiles_.any()) return true;
+
+    const uint32_t start = micros();
+    tiles_.for_each_run([&](const Rect& r){ px::fill_rect(*frame, r.x, r.y, r.w, r.h, TFT_BLACK); });
+    for (auto& s : page) {
+      const Rect& b = s.bounds;
+      if (!tiles_.touches(b)) continue;
+      TFT_eSprite& spr = scratch_for_(s.item, b.w, b.h);
+      px::fill_rect(spr, 0, 0, b.w, b.h, TFT_BLACK);
+      const uint32_t t0 = perf_.now();
+      s.item->RenderIfDirty(tft_, spr);
+      perf_.add_render(perf_.now() - t0);
+      if (s.item == click_.item && !click_.shown) click_.drawn = true;
+      tiles_.for_each_run([&](const Rect& r){
+        const Rect c = intersect(r, b);
+        if (empty(c)) return;
+        if (s.item->Opaque()) pusher_.copy_to16(spr, c.x - b.x, c.y - b.y, c.w, c.h, *frame, c.x, c.y);
+        else pusher_.copy_over16(spr, c.x - b.x, c.y - b.y, c.w, c.h, *frame, c.x, c.y);
+      });
+    }
+
+    uint32_t frame_px = 0;
+    frame_begin_();
+    tiles_.for_each_run([&](const Rect& r){
+      pusher_.push(*frame, r.x, r.y, r.x, r.y, r.w, r.h);
+      frame_px += r.w * r.h;
+    });
+    frame_end_();
+    frame_done_(frame_px, start, false);
+    return true;
+  }
+
+  // Screen-sized 16-bit frame for the compositor; nullptr (compositor off)
+  // if PSRAM cannot hold it.
+  TFT_eSprite* compose_frame_(){
+    if (compose_) return compose_;
+    compose_ = new TFT_eSprite(&tft_);
+    compose_->setAttribute(PSRAM_ENABLE, 1);
+    compose_->setColorDepth(16);
+    if (!compose_->createSprite(screen_.w, screen_.h)) {
+      delete compose_;
+      compose_ = nullptr;
+      compositor_ = false;
+      ESP_LOGW(TAG, "compositor: no memory for a %dx%d frame, pushing items directly", screen_.w, screen_.h);
+      return nullptr;
+    }
+    compose_->fillSprite(TFT_BLACK);
+    compose_all_ = true;
+    return compose_;
+  }
+
+  // Renders and pushes one item if it is dirty. Returns false if it was clean.
+  bool render_item_(ItemStore::Slot& s, uint32_t& frame_px){
+    IPanelItem* it = s.item;
+    if (!it->ClearDirty()) return false;
+
+    // Sprite of the item's format, at least the item's size; only grows (rare).
+    const Rect& b = s.bounds;
+    TFT_eSprite& spr = scratch_for_(it, b.w, b.h);
+
+    // Items may report sub-rectangles; none means repaint the whole cell.
+    Rect dmg[MAX_DAMAGE_RECTS];
+    int n = it->TakeDamage(dmg, MAX_DAMAGE_RECTS);
+    const bool full = n == 0;
+    if (full) { dmg[0] = {0, 0, b.w, b.h}; n = 1; }
+
+    // Clear only what will be pushed before the item draws.
+    // TFT_BLACK is also palette index 0 for 4-bit items.
+    for (int i=0;i<n;++i) px::fill_rect(spr, dmg[i].x, dmg[i].y, dmg[i].w, dmg[i].h, TFT_BLACK);
+
+    // Let the item render into the shared sprite while the previous item
+    // is still streaming out of the push buffers.
+    const uint32_t t0 = perf_.now();
+    it->RenderIfDirty(tft_, spr);
+    perf_.add_render(perf_.now() - t0);
+    if (it == click_.item && !click_.shown) click_.drawn = true;
+
+    if (full && solid_fills_ && push_split_(it, b, spr)) { frame_px += b.w * b.h; return true; }
+    frame_begin_();
+    for (int i=0;i<n;++i) {
+      const Rect& d = dmg[i];
+      pusher_.push(spr, b.x + d.x, b.y + d.y, d.x, d.y, d.w, d.h);
+      if (cached_) pusher_.copy_to16(spr, d.x, d.y, d.w, d.h, *cached_, b.x + d.x, b.y + d.y);
+      frame_px += d.w * d.h;
+    }
+    return true;
+  }
+
+  // A full repaint of an item as window fills for the solid areas of its draw
+  // list and sprite pushes for the rest (corners, strokes, text). The
+  // controller has no fill command, so a fill still clocks every pixel out,
+  // but without converting, staging or DMA-ing them. False if the item has no
+  // draw list or nothing in it is worth a fill; the caller pushes the cell.
+  bool push_split_(IPanelItem* it, const Rect& b, TFT_eSprite& spr) {
+    DrawCmd cmds[MAX_DRAW_CMDS];
+    const int n = it->DrawList(cmds, MAX_DRAW_CMDS);
+    if (!n) return false;
+    const bool ok = split_.split(cmds, n, b.w, b.h, [&](const DrawCmd& c){
+      const int tw = tft_.textWidth(c.text, c.font), th = tft_.fontHeight(c.font);
+      return Rect{c.r.x + (c.r.w - tw) / 2, c.r.y + (c.r.h - th) / 2, tw, th};
+    });
+    if (!ok) return false;
+
+    frame_begin_();
+    pusher_.wait();                      // fills write to the bus directly
+    for (int i = 0; i < split_.fills(); ++i) {
+      const SolidSplit::Fill& f = split_.fill(i);
+      const uint16_t c = sprite_color_(it, f.color);
+      tft_.fillRect(b.x + f.r.x, b.y + f.r.y, f.r.w, f.r.h, c);
+      if (cached_) px::fill_rect(*cached_, b.x + f.r.x, b.y + f.r.y, f.r.w, f.r.h, c);
+    }
+    for (int i = 0; i < split_.rests(); ++i) {
+      const Rect& d = split_.rest(i);
+      pusher_.push(spr, b.x + d.x, b.y + d.y, d.x, d.y, d.w, d.h);
+      if (cached_) pusher_.copy_to16(spr, d.x, d.y, d.w, d.h, *cached_, b.x + d.x, b.y + d.y);
+    }
+    return true;
+  }
+
+  // RGB565 that colour c comes out as from the item's sprite, so a fill
+  // matches the pushed pixels around it: RGB332 for 8 bit, the nearest
+  // palette entry for 4 bit.
+  uint16_t sprite_color_(const IPanelItem* it, uint16_t c) {
+    switch (it->ColorDepth()) {
+      case 4:  return it->Palette()[palette_index(it->Palette(), c)];
+      case 8:  return tft_.color8to16(tft_.color16to8(c));
+      default: return c;
+    }
+  }
+
+  // ---------- Diagnostics ----------
+  PerfStats perf_;
+#ifdef TOUCH_PANEL_PERF
+  esphome::sensor::Sensor* perf_sensors_[PERF_COUNT]{};
+  uint32_t perf_interval_ms_{10000};
+  uint32_t perf_last_ms_{0};
+
+  void publish_perf_() {
+    const uint32_t now = millis();
+    float v[PERF_COUNT];
+    perf_.snapshot(now - perf_last_ms_, scratch_bytes_(), WIRE_BYTES_PER_PX, v);
+    perf_last_ms_ = now;
+    for (int i = 0; i < PERF_COUNT; ++i)
+      if (perf_sensors_[i]) perf_sensors_[i]->publish_state(v[i]);
+  }
+#endif
+
+  // ---------- Benchmark ----------
+  void run_benchmark_(int iters){
+    ESP_LOGI(TAG, "benchmark: %d iterations, %d wire bytes/px", iters, WIRE_BYTES_PER_PX);
+    ESP_LOGI(TAG, "  %-4s %-28s %-7s %9s %9s %9s %9s %9s", "page", "item", "size", "render us", "push us", "bytes",
+             "split us", "sprite B");
+
+    // Items of every page go through the same cells: keep them out of the
+    // visible page's cached frame.
+    TFT_eSprite* const cached = cached_;
+    cached_ = nullptr;
+    for (int p = 0; p < store_.page_count(); ++p) {
+      for (auto& s : store_.page(p)) {
+        const Rect& b = s.bounds;
+        uint32_t render_us = 0, push_us = 0, split_us = 0;
+        for (int i = 0; i < iters; ++i) {
+          s.item->SetBounds(b);            // force a full repaint
+          s.item->ClearDirty();
+          Rect dmg[MAX_DAMAGE_RECTS];
+          s.item->TakeDamage(dmg, MAX_DAMAGE_RECTS);
+          TFT_eSprite& spr = scratch_for_(s.item, b.w, b.h);
+          px::fill_rect(spr, 0, 0, b.w, b.h, TFT_BLACK);
+
+          uint32_t t0 = micros();
+          s.item->RenderIfDirty(tft_, spr);
+          uint32_t t1 = micros();
+          frame_begin_();
+          pusher_.push(spr, b.x, b.y, 0, 0, b.w, b.h);
+          frame_end_();
+          uint32_t t2 = micros();
+          render_us += t1 - t0;
+          push_us += t2 - t1;
+          // The same cell with its solid areas as window fills, if it has a draw list.
+          if (push_split_(s.item, b, spr)) {
+            frame_end_();
+            split_us += micros() - t2;
+          }
+        }
+        // Bytes that go through the sprite path (conversion, staging, DMA):
+        // all of them, or with a draw list only what is not a window fill.
+        const uint32_t cell_px = b.w * b.h;
+        const uint32_t sprite_px = split_us ? cell_px - split_.solid_px() : cell_px;
+        char size[12];
+        snprintf(size, sizeof(size), "%dx%d", b.w, b.h);
+        ESP_LOGI(TAG, "  %-4d %-28s %-7s %9u %9u %9u %9u %9u", p, s.item->Id(), size,
+                 (unsigned)(render_us / iters), (unsigned)(push_us / iters),
+                 (unsigned)(cell_px * WIRE_BYTES_PER_PX), (unsigned)(split_us / iters),
+                 (unsigned)(sprite_px * WIRE_BYTES_PER_PX));
+      }
+    }
+    cached_ = cached;
+
+    // Full visible page and wake-up (black screen + full page), unbudgeted.
+    const uint32_t budget = render_budget_us_;
+    render_budget_us_ = 0;
+    uint32_t page_us = 0, wake_us = 0;
+    uint64_t px0 = total_px_;
+    for (int i = 0; i < iters; ++i) {
+      uint32_t t0 = micros();
+      invalidate_visible_page_();
+      render_page_();
+      uint32_t t1 = micros();
+      tft_tx([&](){ tft_.fillScreen(TFT_BLACK); });
+      show_page_(false);                   // as on wake-up: the cached frame, if any
+      render_page_();
+      uint32_t t2 = micros();
+      page_us += t1 - t0;
+      wake_us += t2 - t1;
+    }
+    render_budget_us_ = budget;
+    const uint32_t page_bytes = (uint32_t)((total_px_ - px0) / (2 * iters)) * WIRE_BYTES_PER_PX;
+    ESP_LOGI(TAG, "  page %d: full redraw %u us, wake-up %u us, %u bytes", (int) current_page_,
+             (unsigned)(page_us / iters), (unsigned)(wake_us / iters), (unsigned) page_bytes);
+
+    // Clear and wire-conversion kernels alone, one band per scratch format.
+    std::vector<uint8_t> out(PushPipeline::BUF_BYTES + 4);
+    for (auto& sc : scratch_) {
+      if (!sc.w) continue;
+      const int rows = std::max(1, std::min(sc.h, PushPipeline::BUF_PX / sc.w));
+      const uint32_t n = (uint32_t) iters * sc.w * rows;
+      uint32_t t0 = micros();
+      for (int i = 0; i < iters; ++i) px::fill_rect(sc.spr, 0, 0, sc.w, rows, TFT_BLACK);
+      uint32_t t1 = micros();
+      for (int i = 0; i < iters; ++i) pusher_.pack(sc.spr, 0, 0, sc.w, rows, out.data());
+      uint32_t t2 = micros();
+      ESP_LOGI(TAG, "  %2d-bit kernels: fill %.1f px/us, convert %.1f px/us", sc.spr.getColorDepth(),
+               (float) n / std::max<uint32_t>(1, t1 - t0), (float) n / std::max<uint32_t>(1, t2 - t1));
+    }
+  }
+
   // ---------- Grid helpers ----------
   void compute_grid_(){
     cell_cache_.clear();
@@ -321,81 +921,202 @@ private:
   }
 
   // ---------- Page helpers ----------
-  void set_page_(int p){
+  // dir: +1/-1 when stepping to the next/previous page, which may animate.
+  void set_page_(int p, int dir = 0){
     current_page_ = (p % (max_page_()+1));
+    render_cursor_ = 0;
+    bus_.page_shown(current_page_);   // what the page missed while hidden
+    TFT_eSprite* f = page_cache_.find(current_page_);
+    if (!dir || !transition_ms_ || !f) { show_page_(false); return; }
+    page_cache_.touch(current_page_);
+    wipe_.frame = f;
+    wipe_.dir = dir;
+    wipe_.shown = 0;
+    wipe_.edge.set_duration(transition_ms_);
+    wipe_.edge.set(0);
+    wipe_.edge.to(f->width());
+  }
+
+  // Advances a running page transition by one frame. Items render again
+  // (over the now complete frame) once it has finished.
+  bool wipe_step_(uint32_t now){
+    TFT_eSprite* f = wipe_.frame;
+    if (!f) return false;
+    wipe_.edge.step(now);
+    const int edge = wipe_.edge.value();
+    if (edge > wipe_.shown) {
+      const int w = edge - wipe_.shown;
+      const int x = wipe_.dir > 0 ? f->width() - edge : wipe_.shown;
+      frame_begin_();
+      pusher_.push(*f, x, 0, x, 0, w, f->height());
+      frame_end_();
+      perf_.add_dma_wait(pusher_.take_wait_us());
+      perf_.add_frame(w * f->height());
+      total_px_ += w * f->height();
+      wipe_.shown = edge;
+    }
+    if (!wipe_.edge.active()) wipe_.frame = nullptr;
+    return true;
+  }
+
+  // Repaints the visible page. With a cached frame that is one push; items
+  // that changed while the page was hidden are still dirty and render over
+  // it. Otherwise every item re-renders (into a fresh frame, if caching).
+  void show_page_(bool clear_screen){
+    wipe_.frame = nullptr;
+    if (TFT_eSprite* f = page_cache_.find(current_page_)) {
+      page_cache_.touch(current_page_);
+      frame_begin_();
+      pusher_.push(*f, 0, 0, 0, 0, f->width(), f->height());
+      frame_end_();
+      return;
+    }
+    if (clear_screen) tft_tx([&](){ tft_.fillScreen(TFT_BLACK); });
+    compose_all_ = compositor_;      // the compose frame still holds the last page
     invalidate_visible_page_();
   }
 
-  int max_page_() const {
-    int m=0; for (auto* it: items_) m = std::max(m, it->Page()); return m;
+  // Next (+1) or previous (-1) page, wrapping; render step only.
+  void step_page_(int dir){
+    if (dir > 0) set_page_(current_page_+1, +1);
+    else set_page_(current_page_==0 ? max_page_() : current_page_-1, -1);
   }
 
+  int max_page_() const { return store_.page_count() - 1; }
+
   void invalidate_visible_page_(){
-    for (auto* it : items_) if (it->Page()==current_page_) {
-      auto itb = last_bounds_.find(it);
-      if (itb != last_bounds_.end()) it->SetBounds(itb->second);
-    }
+    for (auto& s : store_.page(current_page_)) s.item->SetBounds(s.bounds);
   }
 
   // ---------- Touch handling ----------
-  void handle_touch_(int x,int y){
-    for (auto it = items_.rbegin(); it != items_.rend(); ++it){
-      IPanelItem* item = *it;
-      if (item->Page()!=current_page_) continue;
-      if (item->HitTest(x,y)) { item->OnClick(); break; }
-    }
-  }
-
-  bool read_touch_(int16_t &x,int16_t &y){
-      // Ensure TFT is not using SPI (DMA or normal)
-  //tft_.dmaWait();        // no-op if DMA not active
-  //tft_.endWrite();       // make sure TFT has released SPI & CS
-
-    bool pressed=false;
-
-    if (touch_irq_>=0){
-      pressed=(digitalRead(touch_irq_)==LOW);
-      if(!pressed) return false;
-    } else {
-      // Serialize against any TFT DMA/writes
-      {
-        std::lock_guard<std::mutex> lk(spi_mtx_);
-      #ifdef TFT_eSPI_ENABLE_DMA
-        tft_.dmaWait();
-      #endif
-        // Ensure TFT is not holding the bus
-        tft_.endWrite();
-        pressed = ts_.touched();  // if this uses SPI on your lib, we're safe now
+  // Reads the controller only when the XPT2046 IRQ has fired or a touch is in
+  // progress; without an IRQ line it polls at TouchEngine::POLL_MS.
+  // The read itself is queued on the bus (touch goes first).
+  void poll_touch_(uint32_t now){
+    const bool has_irq = touch_irq_ >= 0;
+    if (touch_queued_ || !touch_.wants_sample(now, has_irq && ts_.tirqTouched(), has_irq)) return;
+    touch_queued_ = spi_.post(Spi::PRIO_TOUCH, [this](){ read_touch_(); });
+  }
+
+  void read_touch_(){
+    touch_queued_ = false;
+    touch_read_us_ = perf_.now();
+    TS_Point p = ts_.getPoint();     // XPT2046 lib handles its own CS
+    const bool down = p.z >= 5 && p.z <= 4095;
+    touch_.feed(millis(), down, p.x, p.y);
+  }
+
+  // Between DMA bands of a frame: keeps sampling at the poll rate, so a long
+  // frame does not stall a drag. Events are dispatched on the next step.
+  void touch_gap_(){
+    const uint32_t now = millis();
+    if (now - touch_.last_sample_ms() >= TouchEngine::POLL_MS) poll_touch_(now);
+    spi_.gap();
+  }
+
+  // Routes queued events to the item the touch started on.
+  void dispatch_touch_(){
+    TouchEvent e;
+    while (touch_.pop(e)) {
+      if (e.type == TouchType::PRESS) touch_target_ = render_first_ = hit_item_(e.x, e.y);
+      const bool used = touch_target_ && touch_target_->OnTouch(e);
+      if (used && e.type == TouchType::CLICK) watch_click_(touch_target_);
+      // Already on the render step: step directly, cmds_ has one producer.
+      if (!used && swipe_pages_) {
+        if (e.type == TouchType::SWIPE_LEFT) step_page_(+1);
+        else if (e.type == TouchType::SWIPE_RIGHT) step_page_(-1);
       }
-      if (!pressed) return false;
+      if (e.type == TouchType::RELEASE) touch_target_ = nullptr;
     }
+  }
 
-    TS_Point p;
-    if (!touch_read(p)) return false;
-
-    if (p.z<5 || p.z>4095) return false;
+  // A click that left its item pending is drawn in this step and timed
+  // until the entity settles it. A click still waiting on another item is
+  // kept in earlier_ and settled on its own.
+  void watch_click_(IPanelItem* it){
+    if (it->FeedbackState() != IPanelItem::Feedback::PENDING) return;
+    for (auto& c : earlier_)
+      if (c.item == it) c.item = nullptr;     // superseded by this click
+    if (click_.item && click_.item != it && !settle_(click_)) {
+      PendingClick* slot = &earlier_[0];
+      for (auto& c : earlier_) {
+        if (!c.item) { slot = &c; break; }
+        if ((int32_t)(c.t_us - slot->t_us) < 0) slot = &c;   // oldest
+      }
+      if (slot->item) ESP_LOGD(TAG, "click on '%s' no longer tracked", slot->item->Id());
+      *slot = click_;
+    }
+    click_ = {it, touch_read_us_};
+    render_first_ = it;
+  }
 
-    static constexpr int RAW_X_MIN = 200;
-    static constexpr int RAW_X_MAX = 3800;
-    static constexpr int RAW_Y_MIN = 200;
-    static constexpr int RAW_Y_MAX = 3800;
+  // Confirmation is timed when the render step applies the entity's state.
+  void settle_click_(){
+    if (click_.item) settle_(click_);
+    for (auto& c : earlier_)
+      if (c.item) settle_(c);
+  }
 
-    int16_t mx = map(p.y, RAW_Y_MIN, RAW_Y_MAX, 0, 480);
-    int16_t my = map(p.x, RAW_X_MIN, RAW_X_MAX, 0, 320);
-    x = std::max<int16_t>(0, std::min<int16_t>(479, mx));
-    y = std::max<int16_t>(0, std::min<int16_t>(319, my));
+  // Records how c ended, if it has; false while its item is still pending.
+  bool settle_(PendingClick& c){
+    switch (c.item->FeedbackState()) {
+      case IPanelItem::Feedback::PENDING:
+        return false;
+      case IPanelItem::Feedback::CONFIRMED:
+        perf_.set_confirm_latency(perf_.now() - c.t_us);
+        break;
+      case IPanelItem::Feedback::ROLLED_BACK:
+        perf_.add_rollback();
+        break;
+      default:
+        break;
+    }
+    c.item = nullptr;
     return true;
   }
 
+  // Topmost item on the visible page under (x,y).
+  IPanelItem* hit_item_(int x,int y){
+    auto page = store_.page(current_page_);
+    for (auto* s = page.end(); s != page.begin(); ){
+      IPanelItem* item = (--s)->item;
+      if (item->HitTest(x,y)) return item;
+    }
+    return nullptr;
+  }
+
   // ---------- Scratch sprite mgmt ----------
-  void ensure_scratch_(int w, int h){
+  // Scratch sprite for the item's colour depth, at least w x h, with the
+  // item's palette loaded when it is 4-bit.
+  TFT_eSprite& scratch_for_(IPanelItem* it, int w, int h){
+    const int depth = it->ColorDepth();
+    Scratch& s = scratch_[depth == 4 ? 0 : depth == 16 ? 2 : 1];
+    if (depth == 4) w = (w + 1) & ~1;   // keep 4-bit rows byte aligned for the push
     // Only grow; reuse if current is big enough.
-    if (w <= scratch_w_ && h <= scratch_h_) return;
-    scratch_.deleteSprite();
-    scratch_.createSprite(std::max<int16_t>(scratch_w_, w), 
-                          std::max<int16_t>(scratch_h_, h));
-    scratch_w_ = std::max<int16_t>(scratch_w_, w);
-    scratch_h_ = std::max<int16_t>(scratch_h_, h);
+    if (w > s.w || h > s.h) {
+      s.spr.deleteSprite();
+      s.w = std::max(s.w, w);
+      s.h = std::max(s.h, h);
+      s.spr.setColorDepth(depth);
+      s.spr.createSprite(s.w, s.h);
+    }
+    if (depth == 4) s.spr.createPalette(it->Palette());
+    return s.spr;
+  }
+
+  uint32_t scratch_bytes_() const {
+    static constexpr int DEPTHS[3] = {4, 8, 16};
+    uint32_t n = 0;
+    for (int i = 0; i < 3; ++i) n += scratch_[i].w * scratch_[i].h * DEPTHS[i] / 8;
+    return n;
+  }
+};
+
+// ---------- on_click automation of items declared under `items:` ----------
+class ItemClickTrigger : public esphome::Trigger<> {
+public:
+  ItemClickTrigger(Panel* panel, const char* id) {
+    panel->set_item_click(id, [this](){ this->trigger(); });
   }
 };
 